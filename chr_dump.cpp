@@ -1,6 +1,8 @@
 
 #include <iostream>
 #include <string>
+#include <SFML/Graphics.hpp>
+
 #include "Bus.h"
 
 int main(int argc, char* argv[])
@@ -11,7 +13,7 @@ int main(int argc, char* argv[])
         return 1;
     }
 
-    Bus nes(true); // Hide default UI
+    Bus nes;
 
     Cartridge* game = new Cartridge(argv[1]);
 
@@ -38,8 +40,8 @@ int main(int argc, char* argv[])
         for (int row = 0; row < 16; row++) {
             for (int col = 0; col < 16; col++) {
                 for (int pixel_row = 0; pixel_row < 8; pixel_row++) {
-                    uint8_t plane_0 = nes.cartridge->CHR_ROM[256 * row + 16 * col + pixel_row];
-                    uint8_t plane_1 = nes.cartridge->CHR_ROM[256 * row + 16 * col + pixel_row + 8];
+                    uint8_t plane_0 = nes.cartridge->rom->CHR_ROM[256 * row + 16 * col + pixel_row];
+                    uint8_t plane_1 = nes.cartridge->rom->CHR_ROM[256 * row + 16 * col + pixel_row + 8];
 
                     for (int pixel_col = 0; pixel_col < 8; pixel_col++) {
                         uint8_t low_bit = is_bit_set(pixel_col, plane_0);
@@ -72,8 +74,8 @@ int main(int argc, char* argv[])
         for (int row = 0; row < 16; row++) {
             for (int col = 0; col < 16; col++) {
                 for (int pixel_row = 0; pixel_row < 8; pixel_row++) {
-                    uint8_t plane_0 = nes.cartridge->CHR_ROM[0x1000 + 256 * row + 16 * col + pixel_row];
-                    uint8_t plane_1 = nes.cartridge->CHR_ROM[0x1000 + 256 * row + 16 * col + pixel_row + 8];
+                    uint8_t plane_0 = nes.cartridge->rom->CHR_ROM[0x1000 + 256 * row + 16 * col + pixel_row];
+                    uint8_t plane_1 = nes.cartridge->rom->CHR_ROM[0x1000 + 256 * row + 16 * col + pixel_row + 8];
 
                     for (int pixel_col = 7; pixel_col >= 0; pixel_col--) {
                         uint8_t low_bit = is_bit_set(pixel_col, plane_0);
@@ -6,6 +6,8 @@
 #include <iomanip>
 #include <sstream>
 
+#include <SFML/Graphics.hpp>
+
 #include "Bus.h"
 #include "Helpers.h"
 
@@ -278,7 +280,7 @@ void draw_cpu_state(CPU* cpu, PPU* ppu) {
 
 }
 
-void step_forward(Bus nes) {
+void step_forward(Bus& nes) {
     // Retrieve CPU status
     Snapshot cur_status = Snapshot(
         nes.read_cpu(nes.cpu->program_counter),
@@ -315,7 +317,7 @@ void step_forward(Bus nes) {
 
 int main() {
 
-    Bus nes = Bus(true);
+    Bus nes = Bus();
 
     string rom_name = "official_only.nes";
 
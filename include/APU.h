@@ -1,9 +1,27 @@
-
 #pragma once
 
 #include <cstdint>
+#include <vector>
 
+#include "AudioOutput.h"
+#include "BlipBuffer.h"
 #include "Bus.h"
+#include "SaveState.h"
+
+struct APUWorker;
+
+// Volume envelope shared by the pulse and noise channels. Clocked by quarter frames
+struct Envelope {
+    bool start = false;
+    uint8_t divider = 0;
+    uint8_t decay_level = 0;
+
+    // period is the channel's volume bits, loop is its length counter halt bit
+    void clock(uint8_t period, bool loop);
+
+    void save_state(StateWriter&) const;
+    void load_state(StateReader&);
+};
 
 struct Pulse_Channel {
 
@@ -23,8 +41,39 @@ struct Pulse_Channel {
     uint16_t timer;
     uint8_t sound_length;
 
+    // Pulse 1 negates its sweep with one's complement, pulse 2 with two's complement
+    bool is_pulse_1 = false;
+
+    // CPU cycles until the sequencer next steps
+    uint32_t timer_counter = 1;
+    uint8_t duty_step = 0;
+    uint8_t length_counter = 0;
+
+    Envelope envelope;
+
+    bool sweep_reload = false;
+    uint8_t sweep_divider = 0;
+
     Pulse_Channel() : duty(0), length_counter_halted(0), is_volume_constant(0), volume(0), sweep_enabled(0), sweep_period(0), is_sweep_negated(0), sweep_shift(0), timer(0), sound_length(0)  {}
 
+    // The timer counts APU cycles, so one step takes 2 CPU cycles per count
+    uint32_t period() const { return 2 * (timer + 1); }
+
+    // Run the timer for the given number of CPU cycles
+    void run_timer(uint32_t cycles);
+    void clock_length_counter();
+    void clock_sweep();
+
+    // The period the sweep unit would switch to. Also mutes the channel when it's out of range
+    uint16_t sweep_target() const;
+
+    uint8_t output() const;
+
+    // Whether stepping the sequencer can change the output
+    bool is_audible() const;
+
+    void save_state(StateWriter&) const;
+    void load_state(StateReader&);
 };
 
 struct Triangle_Channel {
@@ -37,42 +86,111 @@ struct Triangle_Channel {
     uint16_t timer;
     uint8_t sound_length;
 
+    // CPU cycles until the timer next expires
+    uint32_t timer_counter = 1;
+    uint8_t sequence_step = 0;
+    uint8_t length_counter = 0;
+    uint8_t linear_counter = 0;
+    bool linear_counter_reload_flag = false;
+
     Triangle_Channel() : length_counter_halted(0), linear_counter_reload(0), timer(0), sound_length(0) {}
 
+    uint32_t period() const { return timer + 1; }
+
+    void run_timer(uint32_t cycles);
+    void clock_length_counter();
+    void clock_linear_counter();
+
+    // The sequencer only steps while both counters are nonzero
+    bool is_stepping() const;
+
+    uint8_t output() const;
+
+    void save_state(StateWriter&) const;
+    void load_state(StateReader&);
 };
 
 
 struct Noise_Channel {
 
     // Updated at 400C
-    bool length_counter_halted;
-    bool is_volume_constant;
-    uint8_t volume;
+    bool length_counter_halted = false;
+    bool is_volume_constant = false;
+    uint8_t volume = 0;
 
     // Updated at 400E
-    bool loop_noise;
-    uint8_t noise_period;
-    
+    bool loop_noise = false;
+    uint8_t noise_period = 0;
+
     // Updated at 400F
-    uint8_t sound_length;
+    uint8_t sound_length = 0;
+
+    // CPU cycles until the shift register next shifts
+    uint32_t timer_counter = 1;
+    uint8_t length_counter = 0;
+
+    // 15 bit linear feedback shift register, loaded with 1 at power up
+    uint16_t shift_register = 1;
 
+    Envelope envelope;
+
+    uint32_t period() const;
+
+    void run_timer(uint32_t cycles);
+    void clock_length_counter();
+
+    uint8_t output() const;
+    bool is_audible() const;
+
+    void save_state(StateWriter&) const;
+    void load_state(StateReader&);
 };
 
 struct DMC_Channel {
 
     // Updated at 4010
-    bool irq_enable;
-    bool is_looping;
-    uint8_t frequency;
+    bool irq_enable = false;
+    bool is_looping = false;
+    uint8_t frequency = 0;
 
     // Updated at 4011
-    uint8_t load_counter;
+    uint8_t load_counter = 0;
 
     // Updated at 4012
-    uint8_t sample_address;
+    uint8_t sample_address = 0;
 
     // Updated at 4013
-    uint8_t sample_length;
+    uint8_t sample_length = 0;
+
+    // CPU cycles until the output unit next clocks
+    uint32_t timer_counter = 1;
+    uint8_t output_level = 0;
+
+    // Output unit
+    uint8_t shift_register = 0;
+    uint8_t bits_remaining = 8;
+    bool is_silent = true;
+
+    // Memory reader
+    uint8_t sample_buffer = 0;
+    bool is_sample_buffer_empty = true;
+    uint16_t current_address = 0;
+    uint16_t bytes_remaining = 0;
+
+    bool irq_flag = false;
+
+    uint32_t period() const;
+
+    void restart_sample();
+
+    // Clock the output unit once
+    void clock_output_unit();
+
+    // Silent with nothing left to play, so clocking the output unit only moves its bit counter
+    bool is_idle() const;
+
+    void save_state(StateWriter&) const;
+    void load_state(StateReader&);
 };
 
 struct APU_Status {
@@ -91,36 +209,141 @@ struct Frame_Counter {
     bool irq_inhibited;
     bool irq_triggered = false;
 
-    uint64_t cycles_elapsed;
+    // CPU cycles since the sequence started
+    uint32_t cycles_elapsed;
 
     Frame_Counter() : mode(0), irq_inhibited(0), cycles_elapsed(0) {}
 
+    // CPU cycles until the next quarter frame, half frame, IRQ or restart of the sequence
+    uint32_t cycles_to_next_step() const;
+
+    void save_state(StateWriter&) const;
+    void load_state(StateReader&);
 };
 
+// How Bus::tick drives the APU. Games only ever run with APU_ON_EVENTS.
+// The other two exist so nesbench can measure what the APU costs
+enum APU_SCHEDULING {APU_ON_EVENTS, APU_EVERY_CYCLE, APU_DISABLED};
+
 struct APU {
     APU();
 
-    Bus* bus;
+    // NTSC CPU clock, which the channels' timers count
+    static constexpr double CPU_CLOCK_RATE = 1789773.0;
+
+    // Samples are handed to audio_output in blocks of this many CPU cycles (a quarter frame)
+    static const uint32_t BLOCK_CYCLES = 7457;
+
+    // CPU cycles a DMC sample fetch takes the bus for (the longest case, when it lands on a read cycle)
+    static const uint32_t DMC_FETCH_STALL_CYCLES = 4;
+
+    // Mixer output (0 - 1) is scaled by this before it becomes a 16-bit sample
+    static constexpr float OUTPUT_SCALE = 30000.0f;
+
+    // Null on an APUWorker's copy, which must never touch the machine
+    Bus* bus = nullptr;
+
+    // Where generated samples go. Channels are only mixed and resampled while there is one
+    AudioOutput* audio_output = nullptr;
+
+    // While attached, register writes and DMC bytes are logged for the worker, which synthesizes the audio on its own thread.
+    // This APU then only answers the machine: $4015 reads, IRQs and DMC fetches
+    APUWorker* worker = nullptr;
+
+    // Set on a worker's copy of the APU, whose DMC takes the bytes logged by the machine's APU instead of reading memory
+    APUWorker* dmc_source = nullptr;
+
+    // CPU cycle the frame being logged for the worker started on
+    uint64_t log_start_cycle = 0;
 
     Pulse_Channel pulse_channel_1;
     Pulse_Channel pulse_channel_2;
 
     Triangle_Channel triangle_channel;
 
+    Noise_Channel noise_channel;
+
     DMC_Channel dmc_channel;
 
     APU_Status apu_status;
 
     Frame_Counter frame_counter;
 
+    // Resamples the mixer output to AudioOutput::SAMPLE_RATE
+    BlipBuffer blip_buffer = BlipBuffer(CPU_CLOCK_RATE, AudioOutput::SAMPLE_RATE, 2 * AudioOutput::SAMPLE_RATE / 60);
+
+    APU_SCHEDULING scheduling = APU_ON_EVENTS;
+
+    // The channels have been run up to this CPU cycle. They fall behind the CPU, and are only caught up
+    // when something could observe them: a register access, an IRQ, a DMC fetch or a finished block of audio
+    uint64_t cycle = 0;
+
+    // Bus::tick catches the APU up once the CPU reaches this cycle
+    uint64_t next_event_cycle = 0;
+
+    // CPU cycle the current block of audio started on
+    uint64_t block_start_cycle = 0;
+
+    // Mixer output at the last change, as a 16-bit amplitude
+    int last_amplitude = 0;
+
+    // Finished samples on their way to audio_output. Allocated once
+    std::vector<int16_t> sample_block = std::vector<int16_t>(2 * AudioOutput::SAMPLE_RATE / 60);
+
     void attach_bus(Bus*);
+    void attach_audio_output(AudioOutput*);
+
+    // Hand audio synthesis to a worker thread, or take it back with nullptr. Whatever the old worker was given is played
+    // out first. Audio goes to the worker's output, so audio_output should stay null while a worker is attached
+    void attach_worker(APUWorker*);
+
+    // Run the channels and frame counter up to the given CPU cycle, one event at a time.
+    // Between events, every timer is advanced in closed form
+    void run_until(uint64_t target_cycle);
+
+    // Run up to the CPU's current cycle
+    void catch_up();
+
+    // CPU cycles until the next point something observable happens: the frame counter steps, the DMC clocks,
+    // the block of audio ends, or (while there is an audio output) a channel's output may change
+    uint32_t cycles_to_next_event() const;
+
+    // Update next_event_cycle after the APU's state changes
+    void schedule_next_event();
 
-    void tick_pulse_channel_1();
-    void tick_pulse_channel_2();
-    void tick_triangle_channel();
+    void clock_frame_counter();
+    void clock_quarter_frame();
+    void clock_half_frame();
 
-    void tick();
+    void run_dmc_timer(uint32_t cycles);
+
+    // Fill the DMC's sample buffer through the bus, stalling the CPU through Bus::stall_cpu
+    void fetch_dmc_sample();
+
+    // Record the mixer output at the current cycle, if it changed
+    void update_output();
+
+    // Mix the channels' current outputs into a 16-bit amplitude, through lookup tables of the NES hardware's nonlinear mixer
+    int mix() const;
+
+    // The same for any channel outputs: pulse, triangle and noise 0 - 15, DMC 0 - 127
+    static int mix_levels(uint8_t pulse_1, uint8_t pulse_2, uint8_t triangle, uint8_t noise, uint8_t dmc);
+
+    // Hand the finished samples of the current block to audio_output
+    void end_block();
 
     uint8_t read_from_cpu(uint16_t);
     void write_from_cpu(uint16_t, uint8_t);
-};
\ No newline at end of file
+
+    // Apply a register write at the current cycle. write_from_cpu catches up first, a worker has already run to the write's cycle
+    void write_register(uint16_t, uint8_t);
+
+    // Hold or release the CPU's IRQ line for the frame counter or the DMC. Each only touches its own source's bit,
+    // so acknowledging one never drops the other's, or the mapper's. Left alone on a worker's copy
+    void raise_cpu_irq(irq_source);
+    void lower_cpu_irq(irq_source);
+
+    // Save or restore channel and frame counter state
+    void save_state(StateWriter&) const;
+    void load_state(StateReader&);
+};
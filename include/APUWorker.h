@@ -0,0 +1,97 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "APU.h"
+#include "AudioOutput.h"
+
+// Synthesizes the APU's audio on its own thread, a frame behind emulation.
+// The machine's APU stays on the emulation thread as a timing model: it answers $4015 reads, raises the frame counter
+// and DMC IRQs and makes the DMC's fetches, but never mixes or resamples. Its register writes and the bytes its DMC
+// fetched are logged with the CPU cycle they happened on, and about once a frame the log is handed over. The worker
+// replays it through its own copy of the APU, which produces exactly the samples the machine's APU would have.
+// The worker synthesizes one frame while emulation logs the next. If it falls further behind, emulation waits for it
+struct APUWorker {
+    // Logs are handed over every this many CPU cycles, about one NTSC frame
+    static const uint32_t FRAME_CYCLES = 29781;
+
+    struct RegisterWrite {
+        uint64_t cycle;
+        uint16_t address;
+        uint8_t value;
+    };
+
+    // Everything the worker needs to synthesize one frame
+    struct FrameLog {
+        std::vector<RegisterWrite> writes;
+
+        // In the order they were fetched. Fetch times follow from the writes, so they aren't needed
+        std::vector<uint8_t> dmc_bytes;
+
+        uint64_t end_cycle = 0;
+    };
+
+    // Samples go to the given output, from the worker thread
+    APUWorker(AudioOutput*);
+
+    // Stops the thread. Detach the worker from the APU first, which plays out what was logged
+    ~APUWorker();
+
+    APUWorker(const APUWorker&) = delete;
+    APUWorker& operator=(const APUWorker&) = delete;
+
+    // Wait for the frame in progress, drop anything logged, and carry on from a copy of the machine's APU.
+    // Called when the worker is attached and when a state is loaded
+    void start(const APU&);
+
+    // Called by the machine's APU, on the emulation thread
+    void log_write(uint64_t cycle, uint16_t address, uint8_t value);
+    void log_dmc_byte(uint8_t);
+
+    // Hand everything logged up to the given cycle to the worker. Waits if it is still on the previous frame
+    void end_frame(uint64_t cycle);
+
+    void wait_until_idle();
+
+    // Called by the worker's APU: the next byte the machine's DMC fetched
+    uint8_t next_dmc_byte();
+
+    AudioOutput* audio_output;
+
+    // The worker's copy. Only touched by the worker thread while it is running
+    APU apu;
+
+    // Filled by the emulation thread
+    FrameLog recording;
+
+    // Handed over to the worker. The emulation thread leaves it alone while has_pending is set
+    FrameLog pending;
+    bool has_pending = false;
+
+    // DMC bytes handed over but not yet fetched by the worker's APU
+    std::vector<uint8_t> dmc_bytes;
+    size_t next_dmc_index = 0;
+
+    std::atomic<uint64_t> frames_synthesized{0};
+
+    // Times end_frame found the worker still busy and had to wait
+    std::atomic<uint64_t> emulation_waits{0};
+
+    std::thread thread;
+    std::mutex lock;
+
+    // Wakes the worker for a new frame or to stop, and emulation when a frame is done
+    std::condition_variable worker_wake;
+    std::condition_variable frame_done;
+    bool stopping = false;
+
+    void run();
+
+    // Replay a frame's log through the worker's APU, which hands finished samples to audio_output
+    void synthesize(const FrameLog&);
+};
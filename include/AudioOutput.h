@@ -0,0 +1,17 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Receives signed 16-bit mono samples from the APU. Implemented by frontends
+struct AudioOutput {
+    static const int SAMPLE_RATE = 48000;
+
+    virtual ~AudioOutput() = default;
+
+    virtual void write_samples(const int16_t*, size_t) = 0;
+
+    // Rate the APU should resample to, asked after every block. Outputs which are drained at the sound card's pace
+    // can move it slightly away from SAMPLE_RATE to keep their buffer level steady
+    virtual double requested_sample_rate() const { return SAMPLE_RATE; }
+};
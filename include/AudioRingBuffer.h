@@ -0,0 +1,41 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Lock-free ring buffer of audio samples between exactly one producer thread and one consumer thread.
+// Only the producer moves write_position and only the consumer moves read_position, so neither side ever waits on the other.
+// Both positions count every sample ever written or read, and are reduced to an index with mask
+struct AudioRingBuffer {
+    // The capacity is rounded up to a power of two
+    AudioRingBuffer(size_t capacity);
+
+    AudioRingBuffer(const AudioRingBuffer&) = delete;
+    AudioRingBuffer& operator=(const AudioRingBuffer&) = delete;
+
+    std::vector<int16_t> samples;
+    size_t mask;
+
+    // On separate cache lines, so the two threads don't keep stealing one line from each other
+    alignas(64) std::atomic<size_t> write_position{0};
+    alignas(64) std::atomic<size_t> read_position{0};
+
+    size_t capacity() const;
+
+    // Samples waiting to be read. Can be out of date by the time it returns, unless called from the consumer
+    size_t size() const;
+
+    // Room left for writing. Can be out of date by the time it returns, unless called from the producer
+    size_t free_space() const;
+
+    // Producer only. Copies in as many of the samples as fit, and returns how many that was
+    size_t write(const int16_t*, size_t);
+
+    // Consumer only. Copies out up to the given number of samples, and returns how many were read
+    size_t read(int16_t*, size_t);
+
+    // Drop everything waiting to be read. Consumer only
+    void clear();
+};
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Band-limited step buffer.
+// The APU's output is a sum of square-ish waves, so it only changes at a few points in time. Instead of
+// producing a sample for every CPU cycle and filtering it down, each change is recorded as an amplitude delta
+// at the clock it happened on. The delta is spread over the neighbouring output samples with a band-limited
+// step kernel, and output samples are the running sum of everything added so far.
+struct BlipBuffer {
+    // Each delta is spread over this many output samples
+    static const int KERNEL_TAPS = 16;
+
+    // Sub-sample positions the kernel is precomputed for
+    static const int PHASE_BITS = 5;
+    static const int NUM_PHASES = 1 << PHASE_BITS;
+
+    // Sample positions are fixed point, with this many fractional bits
+    static const int FRAC_BITS = 32;
+
+    // max_samples: how many samples may be waiting to be read at once
+    BlipBuffer(double clock_rate, double sample_rate, size_t max_samples);
+
+    // Change the resampling ratio. Takes effect for deltas added from now on
+    void set_rates(double clock_rate, double sample_rate);
+
+    // Add an amplitude change at a clock relative to the start of the current block.
+    // Spreads the delta with AVX2 when the CPU has it, otherwise with SSE2 where the build targets it (see vector_extension())
+    void add_delta(uint32_t clock_time, int delta);
+
+    // The paths add_delta chooses between, for tests and benchmarks. The AVX2 one is compiled for AVX2 whatever the
+    // build flags, so only call it when has_avx2() says so. Either falls back to the next narrower path where the
+    // compiler or target can't build it
+    void add_delta_avx2(uint32_t clock_time, int delta);
+    void add_delta_sse2(uint32_t clock_time, int delta);
+
+    // Without vector instructions. What the others are checked against
+    void add_delta_scalar(uint32_t clock_time, int delta);
+
+    // Whether this CPU can run add_delta_avx2. Checked once, on first use
+    static bool has_avx2();
+
+    // Vector instruction set add_delta uses on this CPU: "AVX2", "SSE2" or "none"
+    static const char* vector_extension();
+
+    // End the current block after the given number of clocks. Samples before that point can then be read
+    void end_block(uint32_t num_clocks);
+
+    size_t samples_available() const;
+
+    // Read up to max_samples finished samples, removing them from the buffer. Returns how many were read
+    size_t read_samples(int16_t*, size_t max_samples);
+
+    void clear();
+
+    // Where a delta at the given clock starts in deltas, and the kernel phase for it. False if it falls past the buffer
+    bool locate_delta(uint32_t clock_time, float*& out, const float*& kernel);
+
+    // Output sample position of the start of the current block, in fixed point
+    uint64_t offset = 0;
+
+    // Output samples per clock, in fixed point
+    uint64_t factor = 0;
+
+    std::vector<float> deltas;
+
+    // Running sum of the deltas, and the state of the DC blocking filter applied to it
+    float integrator = 0;
+    float last_input = 0;
+    float last_output = 0;
+};
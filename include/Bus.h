@@ -6,6 +6,7 @@
 #include "Cartridge.h"
 #include "IO.h"
 
+#include <memory>
 #include <vector>
 
 using std::vector;
@@ -26,15 +27,22 @@ struct Bus {
     static const uint16_t RAM_SIZE = 0x2000;
 
     // Increments every time the CPU runs a cycle
-    // For use with frame counter in APU
-    uint32_t num_cpu_cycles = 0;
+    // The APU runs up to this cycle whenever it is caught up
+    uint64_t num_cpu_cycles = 0;
 
     Bus();
-    Bus(bool);
+    ~Bus();
+
+    // Copying a Bus clones the whole machine, see clone()
+    Bus(const Bus&);
+    Bus& operator=(const Bus&) = delete;
 
     CPU* cpu = nullptr;
     PPU* ppu = nullptr;
-    Cartridge* cartridge;
+    Cartridge* cartridge = nullptr;
+
+    // Set on clones, which own a copy of the original's cartridge
+    std::unique_ptr<Cartridge> owned_cartridge;
     IO* io = nullptr;
     APU* apu = nullptr;
 
@@ -42,21 +50,73 @@ struct Bus {
 
     uint64_t num_ticks = 0;
 
+    // Last value on the CPU data bus. Reads nothing responds to return it
+    uint8_t cpu_open_bus = 0;
+
+    // Cycles the CPU still has to sit out for DMA (OAM DMA and DMC sample fetches).
+    // tick() spends them once the current instruction has finished, while the PPU and APU keep running
+    uint32_t cpu_stall_cycles = 0;
+
     bool is_nmi_line_low = false;
     bool is_nmi_suppressed = false;
 
     uint8_t read_cpu(uint16_t);
     void write_cpu(uint16_t, uint8_t); 
 
+    // CPU cycles an OAM DMA suspends the CPU for, plus one more when the write to 0x4014 lands on an odd cycle
+    static const int OAM_DMA_CYCLES = 513;
+
+    // Take the bus away from the CPU for some cycles, after the instruction that is running
+    void stall_cpu(uint32_t);
+
+    // The CPU cycle the running instruction's last cycle falls on, which is when its write reaches the bus.
+    // The CPU runs a whole instruction on its first cycle, so this is ahead of num_cpu_cycles while one is executing
+    uint64_t cpu_write_cycle() const;
+
+    // The 256 bytes at 0xXX00 - 0xXXFF, if reading them has no side effects: internal RAM or PRG ROM.
+    // nullptr for pages which have to go through read_cpu
+    const uint8_t* direct_page(uint8_t) const;
+
+    // Independent copy of this machine, for exploring several inputs from one state.
+    // ROM is shared, VRAM and PRG RAM are shared until either machine writes to them, and everything else is copied.
+    // The clone gets its own virtual controllers (see IO) and has no video or audio output attached.
+    // Must not be called while this machine is running on another thread
+    std::unique_ptr<Bus> clone() const;
+
     void insert_cartridge(Cartridge*);
     void reset();
     void tick();
+
+    // One CPU cycle, and the APU, without the PPU. tick() calls it on every third PPU dot.
+    // NsfPlayer calls it directly, since music files never render
+    void tick_cpu();
+
+    // Tick until the PPU finishes the current frame
+    void run_frame();
+
     void halt();
     void set_nmi_line(bool);
     void set_nmi_suppression_status(bool);
     bool get_nmi_line_status() const;
 
     bool is_open_bus(uint16_t addr) const;
-    
+
+    // Save states cover every component plus the cartridge's mapper state.
+    // A state can only be loaded into a Bus which has the same ROM inserted.
+    static constexpr uint32_t SAVE_STATE_MAGIC = 0x5353454E; // "NESS"
+    static constexpr uint32_t SAVE_STATE_VERSION = 10;
+
+    // Appends the state to the buffer
+    void save_state(std::vector<uint8_t>&) const;
+    void load_state(const uint8_t*, size_t);
+
+    // XXH64 hashes for regression tests and desync detection, cheap enough to take at every frame end.
+    // The state hash covers everything a save state does except the framebuffer: CPU registers and RAM, VRAM, OAM,
+    // palette RAM, the PPU, APU and controller registers, and the cartridge's mapper registers and RAM.
+    // It is fed to the hash piece by piece, without building a state buffer.
+    // hash_frame hashes the screen as it stands, so with frame skipping it repeats the last drawn frame's hash on
+    // skipped frames. Only compare frame hashes taken without frame skipping
+    uint64_t hash_frame() const;
+    uint64_t hash_state() const;
 
 };
\ No newline at end of file
@@ -4,6 +4,8 @@
 #include <vector>
 
 struct Bus;
+struct StateWriter;
+struct StateReader;
 
 /*
     See:
@@ -12,6 +14,9 @@ struct Bus;
 */
 
 enum flag_type {CARRY, ZERO, INT_DISABLE, DECIMAL, BREAK, RESERVED, OVER_FLOW, NEGATIVE};
+// Devices which can hold the IRQ line. It is wired-OR: asserted while any of them holds it, and each acknowledges
+// (releases) only its own bit
+enum irq_source {IRQ_APU_FRAME = 0x01, IRQ_DMC = 0x02, IRQ_MAPPER = 0x04};
 enum addressing_mode {IMPLICIT, ACCUMULATOR, IMMEDIATE, ZERO_PAGE, ZERO_PAGE_X, ZERO_PAGE_Y, RELATIVE, ABSOLUTE, ABSOLUTE_X, ABSOLUTE_Y, INDIRECT, INDEXED_INDIRECT, INDIRECT_INDEXED};
 
 struct CPU {
@@ -33,8 +38,9 @@ struct CPU {
     bool is_nmi_line_low = false;
     bool nmi_edge_detected = false;
 
-    // Flag set if there is an IRQ
-    bool irq_pending = false;
+    // One irq_source bit for every device holding the IRQ line. The line is level triggered, so an IRQ is taken
+    // whenever one is held and interrupts are enabled
+    uint8_t irq_sources = 0;
     
     // The stack pointer stores the low 8 bytes of the next memory location available on the stack
     // 
@@ -66,7 +72,10 @@ struct CPU {
     void toggle_flag(flag_type);
     uint8_t get_byte_from_flags() const;
 
-    void trigger_IRQ();
+    void assert_IRQ(irq_source);
+    void release_IRQ(irq_source);
+
+    // Releases the line for every source
     void reset_IRQ();
 
     // Given an addressing mode and parameters, return the value stored in memory
@@ -104,6 +113,10 @@ struct CPU {
     // Reset CPU state
     void reset();
 
+    // Save or restore registers and interrupt state
+    void save_state(StateWriter&) const;
+    void load_state(StateReader&);
+
     // Opcode implementations
     void ADC(uint8_t);
     void AND(uint8_t);
@@ -1,32 +1,100 @@
 
 #pragma once
+#include <memory>
 #include <vector>
 #include <string>
 
+#include "CowBuffer.h"
+#include "INESHeader.h"
+#include "MappedFile.h"
+#include "RomImage.h"
+#include "SaveState.h"
 #include "mappers/Mapper.h"
 
-enum MIRRORING_TYPE {HORIZONTAL, VERTICAL, FOUR_SCREEN};
+// Single-screen mirroring maps every nametable to the first (A) or second (B) 1 KB of VRAM
+enum MIRRORING_TYPE {HORIZONTAL, VERTICAL, FOUR_SCREEN, SINGLE_SCREEN_A, SINGLE_SCREEN_B};
 
 struct Cartridge {
+    INESHeader header;
 
-    static const uint16_t PRG_ROM_PAGE_SIZE = (1 << 14);
-    static const uint16_t CHR_ROM_PAGE_SIZE = (1 << 13);
-    
-    std::vector<uint8_t> PRG_ROM;
-    std::vector<uint8_t> CHR_ROM;
-    std::vector<int> trainer;
+    // Shared with every cartridge in the process which has the same ROM
+    std::shared_ptr<const RomImage> rom;
+
+    // 4 KB, the smallest PRG bank any supported board switches (mapper 31, which NSF files use)
+    static const uint16_t PRG_PAGE_SIZE = 0x1000;
+    static const int NUM_PRG_PAGES = 8;
+
+    // Where each 4 KB page of 0x8000 - 0xFFFF currently points in PRG ROM.
+    // Refreshed from the mapper whenever it could have switched banks, so reading ROM is a table lookup instead of a virtual call
+    const uint8_t* prg_pages[NUM_PRG_PAGES] = {};
+
+    static const uint16_t CHR_PAGE_SIZE = 0x400;
+    static const int NUM_CHR_PAGES = 8;
+
+    // Where each 1 KB page of the pattern tables (0x0000 - 0x1FFF) currently points, in CHR ROM or CHR RAM.
+    // Refreshed like the PRG page table, and when a write gives this cartridge its own copy of CHR RAM
+    const uint8_t* chr_pages[NUM_CHR_PAGES] = {};
+
+    // Pattern table memory for boards without CHR ROM, sized from the header.
+    // Shared with clones until either side writes to it
+    CowBuffer CHR_RAM;
 
     MIRRORING_TYPE mirroring_type;
 
-    Mapper* mapper;
+    static const uint16_t NAMETABLE_SIZE = 0x400;
 
+    // Where each 1 KB nametable at 0x2000, 0x2400, 0x2800 and 0x2C00 lives in the PPU's VRAM.
+    // Recomputed whenever the mirroring changes, so the PPU never looks at the mirroring type
+    uint16_t nametable_pages[4] = {};
+
+    Mapper* mapper = nullptr;
+
+    // Load a ROM file from the roms directory. The file is memory mapped rather than read
     Cartridge(const std::string&);
 
+    // Load an iNES image which is already in memory. The data is copied, unless another cartridge already loaded the same ROM
+    Cartridge(const uint8_t*, size_t);
+
+    // A copy shares the ROM image and gets its own copy of the mapper
+    Cartridge(const Cartridge&);
+    Cartridge& operator=(const Cartridge&) = delete;
+
+    ~Cartridge();
+
+    // Parse an iNES image. If it lies inside mapping, the ROM image can point straight into the mapping
+    void load_ines(const uint8_t*, size_t, std::shared_ptr<const MappedFile> mapping = nullptr);
+
+    // Change mirroring, for the header and for mappers which switch it
+    void set_mirroring(MIRRORING_TYPE);
+
     bool read_cpu(uint16_t, uint8_t&);
     bool write_cpu(uint16_t, uint8_t);
 
-    bool read_ppu(uint16_t);
-    bool write_ppu(uint16_t, uint8_t);
+    // Ask the mapper where each PRG page points
+    void refresh_prg_pages();
+
+    // Ask the mapper where each CHR page points
+    void refresh_chr_pages();
+
+    // Read PRG ROM by asking the mapper (a virtual call) instead of using the page table.
+    // Only used to check and benchmark the page table
+    bool read_prg_through_mapper(uint16_t, uint8_t&);
+
+    // Pattern table read, through the CHR page table
+    uint8_t read_ppu(uint16_t address) const {
+        return chr_pages[address / CHR_PAGE_SIZE][address % CHR_PAGE_SIZE];
+    }
+
+    // Pattern table write. Only reaches memory on boards with CHR RAM
+    void write_ppu(uint16_t, uint8_t);
+
+    // Keep battery-backed PRG RAM in a save file (usually roms/<game>.sav), loading whatever is already saved there.
+    // Does nothing for cartridges without a battery. Clones of the machine get a copy of the RAM, and never write the file
+    void attach_save_file(const std::string&);
 
     void dump_CHR();
+
+    // Save or restore mirroring, CHR RAM and mapper state. ROM contents are not part of a save state
+    void save_state(StateWriter&) const;
+    void load_state(StateReader&);
 };
\ No newline at end of file
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+
+// Byte buffer which copies share until one of them writes (copy-on-write).
+// Used for memory which is large but rarely written, like VRAM and PRG RAM, so cloning a machine doesn't copy it up front.
+// Copies can be used from different threads, but a buffer must not be copied while its owner is writing to it.
+struct CowBuffer {
+    std::shared_ptr<uint8_t> memory;
+    size_t length = 0;
+
+    // The memory belongs to something else, like a save file. Copies never share it, they get their own copy straight away
+    bool is_external = false;
+
+    CowBuffer(size_t size = 0) : memory(new uint8_t[size](), std::default_delete<uint8_t[]>()), length(size) {}
+
+    // Use memory owned by something else. The shared_ptr keeps the owner alive
+    CowBuffer(std::shared_ptr<uint8_t> external_memory, size_t size) : memory(std::move(external_memory)), length(size), is_external(true) {}
+
+    CowBuffer(const CowBuffer& other) : memory(other.memory), length(other.length) {
+        if (other.is_external) {
+            detach();
+        }
+    }
+
+    CowBuffer& operator=(const CowBuffer& other) {
+        if (this != &other) {
+            memory = other.memory;
+            length = other.length;
+            is_external = false;
+
+            if (other.is_external) {
+                detach();
+            }
+        }
+
+        return *this;
+    }
+
+    CowBuffer(CowBuffer&&) = default;
+    CowBuffer& operator=(CowBuffer&&) = default;
+
+    size_t size() const {
+        return length;
+    }
+
+    bool is_shared() const {
+        return memory.use_count() > 1;
+    }
+
+    uint8_t at(size_t index) const {
+        if (index >= length) {
+            throw std::out_of_range("CowBuffer index out of range");
+        }
+
+        return memory.get()[index];
+    }
+
+    void set(size_t index, uint8_t val) {
+        if (index >= length) {
+            throw std::out_of_range("CowBuffer index out of range");
+        }
+
+        mutable_data()[index] = val;
+    }
+
+    const uint8_t* data() const {
+        return memory.get();
+    }
+
+    // Takes a private copy first if the buffer is shared
+    uint8_t* mutable_data() {
+        if (memory.use_count() > 1) {
+            detach();
+        } else {
+            // If another copy just let go of the buffer, make sure its last reads happen before our writes
+            std::atomic_thread_fence(std::memory_order_acquire);
+        }
+
+        return memory.get();
+    }
+
+    // Move the contents into memory of our own
+    void detach() {
+        std::shared_ptr<uint8_t> copy(new uint8_t[length], std::default_delete<uint8_t[]>());
+        std::memcpy(copy.get(), memory.get(), length);
+        memory = copy;
+        is_external = false;
+    }
+};
@@ -1,9 +1,31 @@
 
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
 #include <string>
 
 bool is_bit_set(int, uint8_t);
 uint16_t form_address(uint8_t, uint8_t);
 bool is_positive(uint8_t);
-std::string get_hex_string(uint16_t, int);
\ No newline at end of file
+std::string get_hex_string(uint16_t, int);
+
+// 64-bit xxHash (XXH64). Pass a previous result as the seed to chain hashes together
+static const uint64_t HASH_SEED = 0;
+uint64_t hash_bytes(const uint8_t*, size_t, uint64_t seed = HASH_SEED);
+
+// XXH64 over data which arrives in pieces. Gives the same result as hash_bytes over all of it at once
+struct StreamingHash {
+    StreamingHash(uint64_t seed = HASH_SEED);
+
+    void update(const uint8_t*, size_t);
+    uint64_t digest() const;
+
+    uint64_t seed;
+    uint64_t accumulators[4];
+
+    // Input is consumed in 32-byte stripes. The tail of the last update waits here for the next one
+    uint8_t stripe[32];
+    size_t stripe_length = 0;
+    uint64_t total_length = 0;
+};
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+// The 16 byte header at the start of an iNES file, in either the original iNES or the NES 2.0 format.
+// See https://www.nesdev.org/wiki/INES and https://www.nesdev.org/wiki/NES_2.0
+struct INESHeader {
+    static const size_t SIZE = 16;
+    static const size_t TRAINER_SIZE = 512;
+
+    static const size_t PRG_ROM_UNIT = 0x4000;
+    static const size_t CHR_ROM_UNIT = 0x2000;
+    static const size_t PRG_RAM_UNIT = 0x2000;
+
+    bool is_nes2 = false;
+
+    uint16_t mapper_number = 0;
+    uint8_t submapper_number = 0;
+
+    size_t prg_rom_size = 0;
+    size_t chr_rom_size = 0;
+
+    // RAM on the cartridge. NVRAM is battery backed.
+    // iNES headers rarely give these, so they fall back to what most boards have: 8 KB of PRG RAM
+    // (battery backed if the battery flag is set), and 8 KB of CHR RAM if there is no CHR ROM
+    size_t prg_ram_size = 0;
+    size_t prg_nvram_size = 0;
+    size_t chr_ram_size = 0;
+    size_t chr_nvram_size = 0;
+
+    bool has_trainer = false;
+    bool has_battery = false;
+    bool has_vertical_mirroring = false;
+    bool has_four_screen_vram = false;
+
+    INESHeader() = default;
+
+    // Throws if the data doesn't start with an iNES header
+    INESHeader(const uint8_t*, size_t);
+
+    // Where PRG ROM starts in the file, after the header and trainer
+    size_t prg_rom_offset() const;
+};
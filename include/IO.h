@@ -1,19 +1,37 @@
-
-#include "controllers/StandardController.h"
+#pragma once
+#include "controllers/VirtualController.h"
 
 struct IO {
 
     uint8_t read_from_cpu();
     uint8_t write_from_cpu();
 
-    Controller* port1_controller = new StandardController();
+    // Controller plugged into port 1 unless another one is connected.
+    // Its buttons are set by the host, frontends connect their own controller instead
+    VirtualController default_controller;
+
+    Controller* port1_controller = &default_controller;
     Controller* port2_controller = nullptr;
 
-    bool strobe_mode;
+    // Only used by copies, which can't share the original's port 2 controller
+    VirtualController port2_default_controller;
+
+    bool strobe_mode = false;
+
+    IO() = default;
+
+    // A copy gets its own virtual controllers, starting with the state (and held buttons) of the controllers it replaces.
+    // This way a cloned machine never shares input with the original
+    IO(const IO&);
+    IO& operator=(const IO&) = delete;
 
     void connect_controller(Controller*, uint8_t);
 
     uint8_t read_from_cpu(uint16_t);
     void write_from_cpu(uint16_t, uint8_t);
 
+    // Save or restore the state of the connected controllers
+    void save_state(StateWriter&) const;
+    void load_state(StateReader&);
+
 };
\ No newline at end of file
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+// Read-only memory mapping of a whole file. The file's pages are only read in when they are used,
+// and are shared with every other process mapping the same file
+struct MappedFile {
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+
+    MappedFile(const std::string& path);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+};
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Recorded controller input, one entry per frame.
+// Loaded from FCEUX .fm2 movies: each input line looks like "|0|RLDUTSBA|RLDUTSBA||",
+// where a '.' or ' ' means the button is released.
+struct Movie {
+    // Button bits are in the order VirtualController expects (bit 0: A ... bit 7: Right)
+    std::vector<uint8_t> port1_inputs;
+    std::vector<uint8_t> port2_inputs;
+
+    Movie(const std::string&);
+
+    size_t num_frames() const;
+
+    // Convert a "RLDUTSBA" field of an .fm2 input line into a button byte
+    static uint8_t parse_fm2_buttons(const std::string&);
+};
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// An NSF music file: 6502 code and data for the sound driver of a game, with the addresses of its INIT and PLAY routines.
+// See https://www.nesdev.org/wiki/NSF
+struct NsfFile {
+    static const size_t HEADER_SIZE = 0x80;
+
+    // NSF bank switching maps 4 KB banks into 0x8000 - 0xFFFF
+    static const size_t BANK_SIZE = 0x1000;
+
+    uint8_t version = 0;
+
+    // Songs are numbered from 0 here. The header's starting song counts from 1
+    uint8_t num_songs = 0;
+    uint8_t starting_song = 0;
+
+    uint16_t load_address = 0;
+    uint16_t init_address = 0;
+    uint16_t play_address = 0;
+
+    std::string name;
+    std::string artist;
+    std::string copyright;
+
+    // Microseconds between PLAY calls on an NTSC machine (16639 for the usual 60.1 Hz)
+    uint16_t ntsc_play_period_us = 0;
+
+    // Banks for 0x8000 - 0xFFFF when a song starts. Files which don't bank switch get the 32 KB at the load address
+    uint8_t initial_banks[8] = {0, 1, 2, 3, 4, 5, 6, 7};
+    bool is_bank_switched = false;
+
+    // Program data, as it is laid out in 4 KB banks. Bank switched files start their data load_address % 4 KB into the first bank
+    std::vector<uint8_t> prg;
+
+    NsfFile() = default;
+
+    // Throws if the data isn't an NSF file, or needs hardware we don't emulate (PAL only, or expansion audio)
+    NsfFile(const uint8_t*, size_t);
+
+    // An iNES image for mapper 31 with the program as its PRG ROM, plus 8 KB each of PRG RAM and CHR RAM.
+    // Mapper 31 is NSF bank switching as a cartridge board, so loading the image gives the machine an NSF player would have
+    std::vector<uint8_t> build_ines_image() const;
+};
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "Bus.h"
+#include "NsfFile.h"
+
+// Plays NSF music files on the emulated CPU and APU. The PPU is never ticked, since music files don't render anything.
+// The file becomes a mapper 31 cartridge (see NsfFile), and INIT and PLAY are called the way an NSF player's driver does:
+// the return address pushed for them is RETURN_ADDRESS, and a routine has finished once the CPU gets there.
+// Between routines the CPU has nothing to do, so time skips straight to the next PLAY call and the APU catches up in closed form
+struct NsfPlayer {
+    // Unused address space no routine will ever run. The CPU stops there instead of executing it
+    static const uint16_t RETURN_ADDRESS = 0x4100;
+
+    // INIT gets this many CPU cycles (5 seconds) to return before the file is given up on
+    static const uint64_t INIT_TIMEOUT_CYCLES = 5 * 1789773;
+
+    NsfFile nsf;
+    Bus nes;
+    std::unique_ptr<Cartridge> cartridge;
+
+    // CPU cycles between PLAY calls, and the cycle the next one is due on. Not whole numbers at the usual rate
+    double play_period_cycles = 0;
+    double next_play_cycle = 0;
+
+    bool is_routine_running = false;
+
+    uint64_t num_play_calls = 0;
+
+    // PLAY calls left out because the previous one was still running, as a real player would
+    uint64_t num_skipped_play_calls = 0;
+
+    // Load a file from the roms directory
+    NsfPlayer(const std::string&);
+
+    // Load a file which is already in memory
+    NsfPlayer(const uint8_t*, size_t);
+
+    NsfPlayer(const NsfPlayer&) = delete;
+    NsfPlayer& operator=(const NsfPlayer&) = delete;
+
+    // Reset memory and the APU the way the NSF spec asks, bank in the file's initial banks, and run the song's INIT routine.
+    // Songs are numbered from 0. Must be called before running
+    void start_song(uint8_t);
+
+    // Run until the given CPU cycle, calling PLAY on schedule
+    void run_until(uint64_t);
+    void run_seconds(double);
+
+    // Start running a routine, which returns to RETURN_ADDRESS
+    void call_routine(uint16_t);
+    bool has_routine_returned() const;
+
+    void load(const uint8_t*, size_t);
+};
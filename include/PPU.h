@@ -3,9 +3,12 @@
 
 #include <stdexcept>
 #include "Cartridge.h"
-#include "UI.h"
+#include "CowBuffer.h"
+#include "Screen.h"
+#include "VideoOutput.h"
 #include "Helpers.h"
 #include "Bus.h"
+#include "SaveState.h"
 
 enum TILE_POSITION {TOP_LEFT, TOP_RIGHT, BOTTOM_LEFT, BOTTOM_RIGHT};
 
@@ -154,7 +157,7 @@ struct PPUSTATUS {
 };
 
 struct PPU {
-    static const int VRAM_SIZE = 0x3000;
+    static const int VRAM_SIZE = 0x1000;
     static const int PALETTE_TABLE_SIZE = 32;
     static const int PRIMARY_OAM_SIZE = 0x100;
     static const int SECONDARY_OAM_SIZE = 0x20;
@@ -162,8 +165,9 @@ struct PPU {
     static const int VISIBLE_SCANLINES_PER_CYCLE = 240;
     static const int SPRITE_WIDTH = 8;
 
-    // Stores CHR data and nametable data
-    vector<uint8_t> VRAM = vector<uint8_t>(VRAM_SIZE);
+    // Nametables: the PPU's own 2 KB, followed by the 2 KB four screen boards add. CHR RAM lives on the cartridge.
+    // Shared with clones until either side writes to it
+    CowBuffer VRAM = CowBuffer(VRAM_SIZE);
 
     // Stores indices into the palette table 
     vector<uint8_t> PALETTE_RAM = vector<uint8_t>(PALETTE_TABLE_SIZE);
@@ -182,9 +186,20 @@ struct PPU {
     vector<uint8_t> OAM_buffer = vector<uint8_t>(SECONDARY_OAM_SIZE, 0xFF);
 
     Cartridge* cartridge;
-    UI* ui = nullptr;
     Bus* bus = nullptr;
 
+    // The frame being drawn. Handed to video_output (if there is one) when it's finished
+    Screen screen;
+    VideoOutput* video_output = nullptr;
+
+    // Only one frame in every frame_skip + 1 is drawn. Skipped frames still run every dot, so sprite 0 hits, sprite
+    // overflow, VBlank and NMIs happen exactly as they would otherwise, but pixels are only composed where they can set
+    // the sprite 0 hit flag, and video_output never sees the frame. screen keeps the last drawn frame. Set with set_frame_skip
+    uint32_t frame_skip = 0;
+
+    // Whether the frame in progress is one of the skipped ones
+    bool is_skipping_frame = false;
+
     uint16_t scanline = 0;
     uint16_t cur_dot = 0;
 
@@ -216,12 +231,12 @@ struct PPU {
     // False if VBlank NMI flag is false, or if NMI hasn't been triggered yet
     bool has_nmi_triggered = false;
 
-    uint8_t ppudata_read_buffer;
+    uint8_t ppudata_read_buffer = 0;
 
     // How many frames has the PPU rendered so far?
     uint16_t frames_elapsed = 0;
 
-    // Given an address which indexes a nametable, map and return the address to another nametable address which is not a mirror
+    // Given an address in 0x2000 - 0x3EFF, return where that nametable byte lives in VRAM
     uint16_t map_to_nametable(uint16_t);
 
     // Perform a read/write from CPU address space
@@ -248,6 +263,10 @@ struct PPU {
     // Run sprite evaluation for this scanline and dot
     void run_sprite_evaluation();
 
+    // Tell the mapper about the pattern table fetch real hardware makes on this dot.
+    // Pixels are drawn from on-demand reads, so mappers which watch A12 would otherwise see the wrong timing
+    void report_pattern_fetch();
+
     // Functions for incrementing scroll registers
 
     // Increment the coarse X value in v by one. Accounts for nametable wrapping
@@ -273,6 +292,15 @@ struct PPU {
     uint8_t num_sprites_found = 0;
 
     void attach_bus(Bus*);
+    void attach_video_output(VideoOutput*);
+
+    void set_frame_skip(uint32_t);
+
+    // Work out whether the current frame is skipped, from frame_skip and frames_elapsed
+    void update_frame_skipping();
+
+    // In a skipped frame, whether the pixel on the current dot has to be composed anyway, because it could set the sprite 0 hit flag
+    bool is_pixel_needed_when_skipping() const;
 
     enum PPU_RENDERING_STAGE {PRE_RENDER, VISIBLE, POST_RENDER, VBLANK};
 
@@ -285,6 +313,9 @@ struct PPU {
     // Resets PPU to startup state
     void reset();
 
+    // Save or restore memory, registers and rendering progress
+    void save_state(StateWriter&) const;
+    void load_state(StateReader&);
+
     PPU();
-    PPU(bool);
 };
\ No newline at end of file
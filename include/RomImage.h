@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#include "MappedFile.h"
+
+// Read-only view of bytes owned by something else
+struct ByteView {
+    const uint8_t* bytes = nullptr;
+    size_t length = 0;
+
+    const uint8_t* data() const {
+        return bytes;
+    }
+
+    size_t size() const {
+        return length;
+    }
+
+    uint8_t operator[](size_t index) const {
+        return bytes[index];
+    }
+
+    uint8_t at(size_t index) const {
+        if (index >= length) {
+            throw std::out_of_range("ByteView index out of range");
+        }
+
+        return bytes[index];
+    }
+};
+
+// ROM contents of a cartridge.
+// An image is never modified after it is loaded, so any number of cartridges (and cloned machines) can share one
+struct RomImage {
+    // Views into either a mapping of the ROM file, or storage
+    ByteView PRG_ROM;
+    ByteView CHR_ROM;
+
+    // Hash of PRG ROM followed by CHR ROM
+    uint64_t content_hash = 0;
+
+    // Keeps whatever the views point into alive
+    std::shared_ptr<const MappedFile> mapping;
+    std::vector<uint8_t> storage;
+
+    RomImage() = default;
+
+    // The views could point into storage, so images can't be copied
+    RomImage(const RomImage&) = delete;
+    RomImage& operator=(const RomImage&) = delete;
+
+    // Returns the image with this content. Every cartridge in the process which loads the same ROM gets the same image,
+    // so running many instances of one game only keeps one copy of its ROM in memory.
+    // If the ROM is new and lies inside mapping, the image points straight into the mapping, otherwise the ROM is copied.
+    // Images are freed once no cartridge uses them any more
+    static std::shared_ptr<const RomImage> load(const uint8_t* prg_rom, size_t prg_rom_size, const uint8_t* chr_rom, size_t chr_rom_size,
+                                                std::shared_ptr<const MappedFile> mapping = nullptr);
+
+    // Number of distinct images currently alive
+    static size_t num_loaded();
+};
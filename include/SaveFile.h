@@ -0,0 +1,36 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// Battery-backed cartridge RAM kept in a file through a shared memory mapping.
+// Writing to the RAM is a plain store into the mapping, so the emulation thread never does I/O.
+// A background thread asks the kernel to write dirty pages back every FLUSH_INTERVAL,
+// and the file is synced when the SaveFile is destroyed.
+struct SaveFile {
+    static constexpr std::chrono::milliseconds FLUSH_INTERVAL{1000};
+
+    uint8_t* data = nullptr;
+    size_t size = 0;
+
+    // Opens the file, creating it if needed. A file of the wrong size is resized, keeping its contents
+    SaveFile(const std::string& path, size_t size);
+    ~SaveFile();
+
+    SaveFile(const SaveFile&) = delete;
+    SaveFile& operator=(const SaveFile&) = delete;
+
+    // Start writing dirty pages back without waiting for them
+    void flush();
+
+    std::thread flusher;
+    std::mutex flusher_lock;
+    std::condition_variable flusher_wake;
+    bool stopping = false;
+
+    void run_flusher();
+};
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "Helpers.h"
+
+// Helpers for writing and reading save states.
+// A state is a flat byte buffer. Every component writes its fields in a fixed order and reads them back in the same order.
+
+struct StateWriter {
+    std::vector<uint8_t>* data = nullptr;
+    StreamingHash* hash = nullptr;
+
+    StateWriter(std::vector<uint8_t>& buffer) : data(&buffer) {}
+
+    // Feeds the state straight into a hash instead of storing it
+    StateWriter(StreamingHash& state_hash) : hash(&state_hash) {}
+
+    bool is_hashing() const {
+        return hash != nullptr;
+    }
+
+    void write_bytes(const uint8_t* bytes, size_t length) {
+        if (hash != nullptr) {
+            hash->update(bytes, length);
+        } else {
+            data->insert(data->end(), bytes, bytes + length);
+        }
+    }
+
+    template <typename T>
+    void write(const T& value) {
+        static_assert(std::is_trivially_copyable<T>::value, "Only plain values can be written directly");
+        write_bytes(reinterpret_cast<const uint8_t*>(&value), sizeof(T));
+    }
+
+    // Length-prefixed buffer
+    void write_buffer(const uint8_t* bytes, size_t length) {
+        write<uint32_t>(length);
+        write_bytes(bytes, length);
+    }
+
+    void write_vector(const std::vector<uint8_t>& bytes) {
+        write_buffer(bytes.data(), bytes.size());
+    }
+};
+
+struct StateReader {
+    const uint8_t* data;
+    size_t size;
+    size_t position = 0;
+
+    StateReader(const uint8_t* buffer, size_t buffer_size) : data(buffer), size(buffer_size) {}
+
+    void read_bytes(uint8_t* bytes, size_t length) {
+        if (length > size - position) {
+            throw std::runtime_error("Save state is truncated");
+        }
+
+        std::memcpy(bytes, data + position, length);
+        position += length;
+    }
+
+    template <typename T>
+    void read(T& value) {
+        static_assert(std::is_trivially_copyable<T>::value, "Only plain values can be read directly");
+        read_bytes(reinterpret_cast<uint8_t*>(&value), sizeof(T));
+    }
+
+    // Buffers keep their size, so a state can only be loaded into a machine with the same memory layout
+    void read_buffer(uint8_t* bytes, size_t expected_length) {
+        uint32_t length;
+        read(length);
+
+        if (length != expected_length) {
+            throw std::runtime_error("Save state buffer size mismatch: expected " + std::to_string(expected_length) + ", got " + std::to_string(length));
+        }
+
+        read_bytes(bytes, length);
+    }
+
+    void read_vector(std::vector<uint8_t>& bytes) {
+        read_buffer(bytes.data(), bytes.size());
+    }
+};
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+using std::vector;
+
+// The picture the PPU is drawing, stored as NES color indices (0x00 - 0x3F).
+// Frontends turn the indices into real colors with COLORS, so the core never depends on a graphics library.
+struct Screen {
+
+    static const int SCREEN_WIDTH = 256;
+    static const int SCREEN_HEIGHT = 240;
+
+    static const int PALETTE_SIZE = 0x40;
+
+    // RGBA value of each NES color index
+    static const uint32_t COLORS[PALETTE_SIZE];
+
+    // Row-major, SCREEN_WIDTH * SCREEN_HEIGHT color indices
+    vector<uint8_t> pixels = vector<uint8_t>(SCREEN_WIDTH * SCREEN_HEIGHT);
+
+    uint8_t cur_background_palette[4] = {0, 0, 0, 0};
+    uint8_t cur_sprite_palette[4] = {0, 0, 0, 0};
+
+    void set_pixel(uint16_t, uint16_t, uint8_t, bool);
+    void set_pixel_color(uint16_t, uint16_t, uint8_t);
+    void set_background_palette(uint8_t, uint8_t, uint8_t, uint8_t);
+    void set_sprite_palette(uint8_t, uint8_t, uint8_t, uint8_t);
+};
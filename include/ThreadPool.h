@@ -0,0 +1,57 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed-size work-stealing thread pool.
+// Every worker owns a task queue. A worker takes tasks from the back of its own queue,
+// and once that is empty it steals from the front of the other workers' queues.
+struct ThreadPool {
+
+    struct WorkQueue {
+        std::mutex lock;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    std::vector<std::thread> workers;
+    std::vector<std::unique_ptr<WorkQueue>> queues;
+
+    // Tasks which have been submitted but not finished yet
+    std::atomic<size_t> num_unfinished_tasks{0};
+
+    // Used to put idle workers to sleep, and to wake up threads waiting for the pool to drain
+    std::mutex sleep_lock;
+    std::condition_variable work_available;
+    std::condition_variable all_tasks_done;
+
+    std::atomic<bool> stopping{false};
+
+    // Queue which the next submitted task is placed on
+    std::atomic<size_t> next_queue{0};
+
+    // 0 threads means one per hardware thread
+    ThreadPool(unsigned num_threads = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    size_t size() const;
+
+    // Queue a task. Tasks are spread round-robin over the workers
+    void submit(std::function<void()>);
+
+    // Block until every submitted task has finished
+    void wait_idle();
+
+    // Take a task from the worker's own queue, or steal one from another queue
+    bool take_task(size_t, std::function<void()>&);
+
+    void run_worker(size_t);
+};
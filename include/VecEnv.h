@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Bus.h"
+#include "ThreadPool.h"
+#include "controllers/VirtualController.h"
+
+// Steps N independent instances of one ROM in lockstep, one frame per call.
+// Observations and RAM are written into contiguous tensors so they can be handed to a learner without copying:
+//   observations: [N x 240 x 256] NES color indices
+//   ram:          [N x 2048] CPU work RAM
+// Every instance starts from the same post-boot save state, and can be reset back to it at any time.
+struct VecEnv {
+    static const size_t OBSERVATION_SIZE = Screen::SCREEN_WIDTH * Screen::SCREEN_HEIGHT;
+    static const size_t RAM_SIZE = 0x800;
+
+    struct Instance {
+        std::unique_ptr<Cartridge> cartridge;
+        std::unique_ptr<Bus> bus;
+
+        VirtualController port1;
+        VirtualController port2;
+
+        // Frames since the last reset
+        uint64_t episode_frames = 0;
+    };
+
+    std::vector<std::unique_ptr<Instance>> instances;
+    ThreadPool pool;
+
+    // State every instance is reset to, taken after the boot frames have run
+    std::vector<uint8_t> reset_state;
+
+    // Instances are reset automatically after this many frames. 0 turns automatic resets off
+    uint64_t max_episode_frames;
+
+    std::vector<uint8_t> observations;
+    std::vector<uint8_t> ram;
+
+    // 1 for each instance which was reset at the end of the last step
+    std::vector<uint8_t> dones;
+
+    // Timing of step()
+    uint64_t num_steps = 0;
+    double last_step_seconds = 0;
+    double total_step_seconds = 0;
+
+    // rom_data: iNES image, copied into every instance
+    // boot_frames: frames to run after power on before the reset state is taken
+    // num_threads: 0 means one per hardware thread
+    VecEnv(const uint8_t* rom_data, size_t rom_size, size_t num_envs, unsigned num_threads = 0, uint64_t boot_frames = 0, uint64_t max_episode_frames = 0);
+
+    size_t size() const;
+
+    // Advance every instance by one frame.
+    // inputs holds 2 bytes per instance: the buttons for port 1, then for port 2
+    void step(const uint8_t* inputs);
+
+    // Put one instance, or all of them, back into the reset state
+    void reset(size_t);
+    void reset_all();
+
+    double mean_step_latency_us() const;
+
+    // Emulated frames per second of wall time, summed over all instances
+    double frames_per_second() const;
+
+    // Copy an instance's frame and RAM into the tensors
+    void write_observation(size_t);
+
+    // Run the given range of instances for one frame (called on pool threads)
+    void step_range(size_t, size_t, const uint8_t*);
+};
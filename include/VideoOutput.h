@@ -0,0 +1,10 @@
+#pragma once
+
+#include "Screen.h"
+
+// Receives every finished frame from the PPU. Implemented by frontends (see frontend/UI.h)
+struct VideoOutput {
+    virtual ~VideoOutput() = default;
+
+    virtual void present_frame(const Screen&) = 0;
+};
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "AudioOutput.h"
+#include "AudioRingBuffer.h"
+
+// Streams the APU's samples to a 16-bit mono WAV file, for rendering audio offline and for checking the audio path.
+// write_samples only copies into a lock-free ring, and a background thread empties the ring to disk in large blocks,
+// so the emulation thread never waits on I/O. The sizes in the header aren't known until the end, so close() patches them in.
+struct WavWriter : AudioOutput {
+    // About 22 seconds of audio, so the writer can fall far behind before emulation has to wait for it
+    static const size_t RING_SAMPLES = 1 << 20;
+
+    // The writer waits for at least this many samples before writing, except when closing
+    static const size_t WRITE_BLOCK_SAMPLES = 1 << 16;
+
+    static constexpr std::chrono::milliseconds WRITER_INTERVAL{5};
+
+    static const uint32_t HEADER_SIZE = 44;
+
+    // Creates or truncates the file
+    WavWriter(const std::string& path);
+
+    // Closes the file if close() wasn't called, ignoring errors
+    ~WavWriter();
+
+    WavWriter(const WavWriter&) = delete;
+    WavWriter& operator=(const WavWriter&) = delete;
+
+    void write_samples(const int16_t*, size_t) override;
+
+    // Write out whatever is left, patch the header and close the file. Throws if any write failed
+    void close();
+
+    std::string path;
+    FILE* file = nullptr;
+
+    AudioRingBuffer ring = AudioRingBuffer(RING_SAMPLES);
+
+    // Only touched by the writer thread, and by close() once it has stopped
+    std::vector<int16_t> write_block = std::vector<int16_t>(WRITE_BLOCK_SAMPLES);
+    uint64_t samples_written = 0;
+
+    // Times write_samples found the ring full and had to wait for the disk
+    std::atomic<uint64_t> producer_waits{0};
+
+    std::atomic<bool> write_failed{false};
+
+    std::thread writer;
+    std::mutex writer_lock;
+    std::condition_variable writer_wake;
+    bool stopping = false;
+
+    void run_writer();
+
+    // Write the ring's contents to the file, once there are at least min_samples of them
+    void drain(size_t min_samples);
+
+    // Write the RIFF header for the given number of samples at the start of the file
+    void write_header(uint64_t num_samples);
+};
@@ -1,6 +1,8 @@
-
+#pragma once
 #include <cstdint>
 
+#include "SaveState.h"
+
 struct Controller {
 
     bool is_strobing = false;
@@ -8,4 +10,13 @@ struct Controller {
     virtual bool read_input() = 0;
     virtual void set_strobe(bool) = 0;
 
+    // Controllers only need to save their shift register state, not the buttons being held
+    virtual void save_state(StateWriter& state) const {
+        state.write(is_strobing);
+    }
+
+    virtual void load_state(StateReader& state) {
+        state.read(is_strobing);
+    }
+
 };
\ No newline at end of file
@@ -1,9 +0,0 @@
-
-#include "Controller.h"
-
-struct StandardController : Controller {
-    uint8_t controller_state = 0;
-
-    bool read_input() override;
-    void set_strobe(bool) override;
-};
\ No newline at end of file
@@ -0,0 +1,20 @@
+#pragma once
+
+#include "Controller.h"
+
+// Standard controller whose buttons are set by the host instead of read from the keyboard.
+// Used for movie playback and headless runs, where every instance needs its own input state.
+struct VirtualController : Controller {
+    // Button bits in the order the NES reads them out:
+    // bit 0: A, 1: B, 2: Select, 3: Start, 4: Up, 5: Down, 6: Left, 7: Right
+    uint8_t buttons = 0;
+    uint8_t controller_state = 0;
+
+    void set_buttons(uint8_t);
+
+    bool read_input() override;
+    void set_strobe(bool) override;
+
+    void save_state(StateWriter&) const override;
+    void load_state(StateReader&) override;
+};
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+#include <SFML/Audio.hpp>
+
+#include "AudioOutput.h"
+#include "AudioRingBuffer.h"
+
+// Plays the APU's samples through SFML.
+// The APU writes samples into a lock-free ring, from the emulation thread or an APUWorker's, and SFML's audio thread drains it,
+// so neither ever blocks the other.
+// The emulator and the sound card run on different clocks, so the APU is asked to resample slightly faster or slower
+// depending on how full the ring is (dynamic rate control). That keeps the ring near its target level instead of slowly
+// running dry or overflowing.
+struct AudioStream : sf::SoundStream, AudioOutput {
+    // Furthest the rate control moves the output rate away from SAMPLE_RATE, as a fraction of it
+    static constexpr double MAX_RATE_ADJUSTMENT = 0.005;
+
+    // Samples handed to SFML per request. SFML keeps a few of these queued
+    static const size_t CHUNK_SAMPLES = 512;
+
+    // target_latency_ms: how much audio the ring holds while the rate control is on target
+    AudioStream(unsigned target_latency_ms = 40);
+    ~AudioStream();
+
+    AudioRingBuffer ring;
+
+    // Fill level the rate control steers towards, in samples
+    size_t target_fill;
+
+    // Requests from SFML the ring couldn't fully answer, so silence was played
+    std::atomic<uint64_t> underruns{0};
+
+    // Samples dropped because the ring was full
+    std::atomic<uint64_t> overflowed_samples{0};
+
+    // When set, write_samples waits while the ring is at its target level, so the sound card's consumption
+    // sets the pace of the whole emulator. Otherwise samples which don't fit are dropped.
+    // Set from the main thread (fast forward) while write_samples may be reading it on an APUWorker's thread
+    std::atomic<bool> paces_emulation{false};
+
+    // Only touched by SFML's audio thread
+    std::vector<int16_t> chunk = std::vector<int16_t>(CHUNK_SAMPLES);
+
+    // The emulation thread, or the APUWorker's thread when audio is synthesized on one
+    void write_samples(const int16_t*, size_t) override;
+    double requested_sample_rate() const override;
+
+    // Audio waiting in the ring, in milliseconds. SFML's own queue adds a few chunks on top of this
+    double latency_ms() const;
+
+protected:
+    // SFML's audio thread
+    bool onGetData(Chunk&) override;
+    void onSeek(sf::Time) override;
+};
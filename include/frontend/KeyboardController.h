@@ -0,0 +1,12 @@
+#pragma once
+
+#include "controllers/VirtualController.h"
+
+// Standard controller driven by the host keyboard through SFML.
+// The buttons are sampled whenever the game writes the strobe bit, which is when a real controller latches them.
+struct KeyboardController : VirtualController {
+    void poll_keyboard();
+
+    bool read_input() override;
+    void set_strobe(bool) override;
+};
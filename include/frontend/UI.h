@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <SFML/Graphics.hpp>
+
+#include "VideoOutput.h"
+
+using std::vector;
+
+struct PixelMap : public sf::Drawable, public sf::Transformable {
+
+    static const int SCREEN_WIDTH = Screen::SCREEN_WIDTH;
+    static const int SCREEN_HEIGHT = Screen::SCREEN_HEIGHT;
+
+    sf::VertexArray vertices;
+
+    void load(const Screen&, const int);
+    virtual void draw(sf::RenderTarget&, sf::RenderStates) const;
+};
+
+// SFML window which shows the frames the PPU presents
+struct UI : VideoOutput {
+
+    static const int SCALE_FACTOR = 3;
+
+    static const int WINDOW_WIDTH = Screen::SCREEN_WIDTH * SCALE_FACTOR;
+    static const int WINDOW_HEIGHT = Screen::SCREEN_HEIGHT * SCALE_FACTOR;
+
+    sf::RenderWindow* window = nullptr;
+
+    UI();
+    ~UI();
+
+    void present_frame(const Screen&) override;
+
+};
\ No newline at end of file
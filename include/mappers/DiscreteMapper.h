@@ -0,0 +1,202 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "Cartridge.h"
+#include "mappers/Mapper.h"
+
+
+/*
+    Boards built from discrete logic: a single latch, written anywhere in the register range, selects the PRG bank,
+    and on some boards the CHR bank or a single-screen nametable too.
+
+    Each board is a description of how the latch is wired, and DiscreteMapper turns it into a mapper.
+    A board defines:
+        REGISTER_START:      Lowest address which writes the latch (the latch covers REGISTER_START - 0xFFFF)
+        PRG_BANK_SIZE:       0x4000 or 0x8000
+        PRG_MASK, PRG_SHIFT: PRG bank = (latch & PRG_MASK) >> PRG_SHIFT
+        FIXED_LAST_PRG_BANK: With 16 KB banks, 0xC000 - 0xFFFF is fixed to the last bank
+        CHR_MASK, CHR_SHIFT: 8 KB CHR bank = (latch & CHR_MASK) >> CHR_SHIFT
+        MIRRORING_MASK:      Latch bit which selects single-screen nametable A or B. 0 if mirroring is fixed
+        BUS_CONFLICTS:       The ROM drives the data bus during the write, so the latch sees value AND the ROM byte
+*/
+template <typename Board>
+struct DiscreteMapper final : Mapper {
+    // No PRG RAM on any of these boards
+    DiscreteMapper(uint16_t prg_rom_banks, uint16_t chr_rom_banks) : Mapper(prg_rom_banks, 0, chr_rom_banks, 0) {
+        update_banks();
+    }
+
+    uint8_t latch = 0;
+
+    // Where each 8 KB window of 0x8000 - 0xFFFF points in PRG ROM, and the 8 KB of CHR in use.
+    // Recomputed on every latch write
+    uint32_t prg_bank_offsets[4] = {};
+    uint32_t chr_bank_offset = 0;
+
+    bool cpu_mapper_read(uint16_t addr, uint32_t& mapped_addr, uint8_t& /* data */) override {
+        if (addr >= 0x8000) {
+            mapped_addr = prg_bank_offsets[(addr - 0x8000) / 0x2000] + (addr % 0x2000);
+            return true;
+        }
+
+        return false;
+    }
+
+    bool cpu_mapper_write(uint16_t addr, uint32_t& /* mapped_addr */, uint8_t data) override {
+        if (addr < Board::REGISTER_START) {
+            return false;
+        }
+
+        if (Board::BUS_CONFLICTS) {
+            uint8_t rom_data;
+            cartridge->read_cpu(addr, rom_data);
+            data &= rom_data;
+        }
+
+        latch = data;
+        update_banks();
+
+        if (Board::MIRRORING_MASK != 0) {
+            cartridge->set_mirroring((latch & Board::MIRRORING_MASK) ? SINGLE_SCREEN_B : SINGLE_SCREEN_A);
+        }
+
+        // We never edit PRG ROM
+        return false;
+    }
+
+    bool ppu_mapper_read(uint16_t addr, uint32_t& mapped_addr) override {
+        if (addr <= 0x1FFF) {
+            mapped_addr = chr_bank_offset + addr;
+            return true;
+        }
+
+        return false;
+    }
+
+    bool ppu_mapper_write(uint16_t addr, uint32_t& mapped_addr, uint8_t /* data */) override {
+        // Only reaches memory on boards with CHR RAM
+        if (addr <= 0x1FFF) {
+            mapped_addr = chr_bank_offset + addr;
+            return true;
+        }
+
+        return false;
+    }
+
+    Mapper* clone() const override {
+        return new DiscreteMapper(*this);
+    }
+
+    void reset() override {
+
+    }
+
+    bool mapped_to_prg_ram(uint16_t /* addr */) override {
+        return false;
+    }
+
+    std::vector<uint8_t> get_prg_ram() override {
+        return std::vector<uint8_t>();
+    }
+
+    void save_state(StateWriter& state) const override {
+        Mapper::save_state(state);
+        state.write(latch);
+    }
+
+    void load_state(StateReader& state) override {
+        Mapper::load_state(state);
+        state.read(latch);
+        update_banks();
+    }
+
+    void update_banks() {
+        uint32_t old_prg_bank_offsets[4];
+        uint32_t old_chr_bank_offset = chr_bank_offset;
+        std::memcpy(old_prg_bank_offsets, prg_bank_offsets, sizeof(prg_bank_offsets));
+
+        // Bank numbers past the end of the ROM are wrapped by the cartridge
+        uint32_t prg_bank = (latch & Board::PRG_MASK) >> Board::PRG_SHIFT;
+        uint32_t last_prg_bank = num_prg_rom_banks * 0x4000 / Board::PRG_BANK_SIZE - 1;
+
+        for (uint32_t window = 0; window < 4; window++) {
+            uint32_t window_start = window * 0x2000;
+            uint32_t bank = prg_bank;
+
+            if (Board::FIXED_LAST_PRG_BANK && window_start >= Board::PRG_BANK_SIZE) {
+                bank = last_prg_bank;
+            }
+
+            prg_bank_offsets[window] = bank * Board::PRG_BANK_SIZE + window_start % Board::PRG_BANK_SIZE;
+        }
+
+        chr_bank_offset = ((latch & Board::CHR_MASK) >> Board::CHR_SHIFT) * 0x2000;
+
+        prg_banks_changed |= std::memcmp(old_prg_bank_offsets, prg_bank_offsets, sizeof(prg_bank_offsets)) != 0;
+        chr_banks_changed |= old_chr_bank_offset != chr_bank_offset;
+    }
+};
+
+
+// Mapper 2: 16 KB PRG bank at 0x8000, last bank fixed at 0xC000, CHR RAM
+struct UxROM {
+    static const uint16_t REGISTER_START = 0x8000;
+    static const uint32_t PRG_BANK_SIZE = 0x4000;
+    static const uint8_t PRG_MASK = 0xFF, PRG_SHIFT = 0;
+    static const bool FIXED_LAST_PRG_BANK = true;
+    static const uint8_t CHR_MASK = 0x00, CHR_SHIFT = 0;
+    static const uint8_t MIRRORING_MASK = 0x00;
+    static const bool BUS_CONFLICTS = true;
+};
+
+// Mapper 7: 32 KB PRG bank, single-screen mirroring selected by bit 4, CHR RAM
+struct AxROM {
+    static const uint16_t REGISTER_START = 0x8000;
+    static const uint32_t PRG_BANK_SIZE = 0x8000;
+    static const uint8_t PRG_MASK = 0x0F, PRG_SHIFT = 0;
+    static const bool FIXED_LAST_PRG_BANK = false;
+    static const uint8_t CHR_MASK = 0x00, CHR_SHIFT = 0;
+    static const uint8_t MIRRORING_MASK = 0x10;
+    static const bool BUS_CONFLICTS = false;
+};
+
+// Mapper 11: 32 KB PRG bank in the low bits, 8 KB CHR bank in the high bits
+struct ColorDreams {
+    static const uint16_t REGISTER_START = 0x8000;
+    static const uint32_t PRG_BANK_SIZE = 0x8000;
+    static const uint8_t PRG_MASK = 0x03, PRG_SHIFT = 0;
+    static const bool FIXED_LAST_PRG_BANK = false;
+    static const uint8_t CHR_MASK = 0xF0, CHR_SHIFT = 4;
+    static const uint8_t MIRRORING_MASK = 0x00;
+    static const bool BUS_CONFLICTS = true;
+};
+
+// Mapper 66: 32 KB PRG bank in bits 4 - 5, 8 KB CHR bank in bits 0 - 1
+struct GxROM {
+    static const uint16_t REGISTER_START = 0x8000;
+    static const uint32_t PRG_BANK_SIZE = 0x8000;
+    static const uint8_t PRG_MASK = 0x30, PRG_SHIFT = 4;
+    static const bool FIXED_LAST_PRG_BANK = false;
+    static const uint8_t CHR_MASK = 0x03, CHR_SHIFT = 0;
+    static const uint8_t MIRRORING_MASK = 0x00;
+    static const bool BUS_CONFLICTS = true;
+};
+
+// Mapper 71: like UxROM, but the bank register is at 0xC000 - 0xFFFF and there are no bus conflicts
+struct Camerica {
+    static const uint16_t REGISTER_START = 0xC000;
+    static const uint32_t PRG_BANK_SIZE = 0x4000;
+    static const uint8_t PRG_MASK = 0x0F, PRG_SHIFT = 0;
+    static const bool FIXED_LAST_PRG_BANK = true;
+    static const uint8_t CHR_MASK = 0x00, CHR_SHIFT = 0;
+    static const uint8_t MIRRORING_MASK = 0x00;
+    static const bool BUS_CONFLICTS = false;
+};
+
+using Mapper002 = DiscreteMapper<UxROM>;
+using Mapper007 = DiscreteMapper<AxROM>;
+using Mapper011 = DiscreteMapper<ColorDreams>;
+using Mapper066 = DiscreteMapper<GxROM>;
+using Mapper071 = DiscreteMapper<Camerica>;
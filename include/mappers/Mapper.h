@@ -3,25 +3,65 @@
 #include <cstdint>
 #include <vector>
 
+#include "CowBuffer.h"
+#include "SaveState.h"
+
+struct Cartridge;
 
 struct Mapper {
-    Mapper(uint8_t prg_rom_banks, uint8_t prg_ram_banks, uint8_t chr_banks, uint16_t ram_bank_size);
+    Mapper(uint16_t prg_rom_banks, uint8_t prg_ram_banks, uint16_t chr_banks, uint16_t ram_bank_size);
+    virtual ~Mapper() = default;
 
-    uint8_t num_prg_rom_banks;
+    // 16 KB PRG ROM and 8 KB CHR banks. NES 2.0 headers allow more than 255 of each
+    uint16_t num_prg_rom_banks;
     uint8_t num_prg_ram_banks;
-    uint8_t num_chr_banks;
+    uint16_t num_chr_banks;
 
     uint16_t prg_ram_bank_size;
-    std::vector<uint8_t> PRG_RAM;
 
+    // Shared with clones until either side writes to it
+    CowBuffer PRG_RAM;
+
+    // The cartridge this mapper sits on, for mappers which switch mirroring
+    Cartridge* cartridge = nullptr;
+
+    // True for mappers which count scanlines by watching PPU A12. The PPU only reports pattern fetches to these
+    bool watches_ppu_a12 = false;
+
+    // Set when a register write moved PRG or CHR banks. The cartridge then refreshes that page table
+    // and clears the flag, so writes which change nothing (IRQ registers, rewriting the same bank) cost no refresh
+    bool prg_banks_changed = false;
+    bool chr_banks_changed = false;
+
+    // State of the mapper's IRQ line. The PPU asserts it on the CPU while it is set,
+    // and the bus clears the CPU's pending IRQ when a register write acknowledges it
+    bool irq_pending = false;
+
+    // Reads of 0x8000 - 0xFFFF must map to PRG ROM in banks of at least 4 KB, and PPU reads of 0x0000 - 0x1FFF
+    // to CHR in banks of at least 1 KB: the cartridge caches the results in its PRG and CHR page tables,
+    // and only asks again after a write which sets prg_banks_changed or chr_banks_changed
     virtual bool cpu_mapper_read(uint16_t addr, uint32_t& mapped_addr, uint8_t& data) = 0;
     virtual bool cpu_mapper_write(uint16_t addr, uint32_t& mapped_addr, uint8_t data) = 0;
     virtual bool ppu_mapper_read(uint16_t addr, uint32_t& mapped_addr) = 0;
     virtual bool ppu_mapper_write(uint16_t addr, uint32_t& mapped_addr, uint8_t data) = 0;
 
+    // Called for the pattern table fetches the PPU makes while rendering (one per 8 dots),
+    // with the address fetched and the PPU dot it happened on
+    virtual void notify_pattern_fetch(uint16_t /* addr */, uint64_t /* dot */) {}
+
+    // Copy of this mapper, for cloning a cartridge
+    virtual Mapper* clone() const = 0;
+
     virtual void reset() = 0;
     virtual bool mapped_to_prg_ram(uint16_t addr) = 0;
     virtual std::vector<uint8_t> get_prg_ram() = 0; // For debugging purposes only
 
+    // Save or restore PRG RAM and bank registers.
+    // Mappers with registers override these and call the base version first
+    virtual void save_state(StateWriter&) const;
+    virtual void load_state(StateReader&);
+
+    void attach_cartridge(Cartridge*);
+
 
 };
\ No newline at end of file
@@ -0,0 +1,60 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "mappers/Mapper.h"
+
+
+// MMC3 (TxROM): 8 KB PRG banks, 1 KB and 2 KB CHR banks, and a scanline counter clocked by PPU A12
+struct Mapper004 final : Mapper {
+    // PRG ROM is switched in 8 KB banks, CHR in 1 KB units
+    static const uint16_t PRG_BANK_SIZE = 0x2000;
+    static const uint16_t CHR_BANK_SIZE = 0x400;
+
+    // A12 must stay low for more than this many PPU dots before a rise clocks the counter.
+    // This ignores the short lows of nametable fetches between pattern fetches from 0x1000 - 0x1FFF
+    static const uint64_t A12_LOW_FILTER_DOTS = 12;
+
+    Mapper004(uint16_t prg_rom_banks, size_t prg_ram_size, uint16_t chr_rom_banks);
+
+    // Bank select ($8000): which bank register the next $8001 write goes to, and the PRG / CHR layouts
+    uint8_t bank_select = 0;
+
+    // R0 - R7: R0 and R1 select 2 KB CHR banks, R2 - R5 1 KB CHR banks, R6 and R7 8 KB PRG banks
+    uint8_t bank_registers[8] = {0, 2, 4, 5, 6, 7, 0, 1};
+
+    bool prg_ram_enabled = true;
+    bool prg_ram_write_protected = false;
+
+    // Scanline counter
+    uint8_t irq_latch = 0;
+    uint8_t irq_counter = 0;
+    bool irq_reload = false;
+    bool irq_enabled = false;
+
+    // A12 as of the last pattern fetch, and the PPU dot (Bus::num_ticks) of the first fetch it was low for
+    bool is_a12_high = false;
+    uint64_t a12_low_dot = 0;
+
+    // Where each 8 KB window of 0x8000 - 0xFFFF and each 1 KB window of 0x0000 - 0x1FFF points.
+    // Recomputed on every bank register write, so mapping an address is an index and an add
+    uint32_t prg_bank_offsets[4] = {};
+    uint32_t chr_bank_offsets[8] = {};
+
+    bool cpu_mapper_read(uint16_t addr, uint32_t& mapped_addr, uint8_t& data) override;
+    bool cpu_mapper_write(uint16_t addr, uint32_t& mapped_addr, uint8_t data) override;
+    bool ppu_mapper_read(uint16_t addr, uint32_t& mapped_addr) override;
+    bool ppu_mapper_write(uint16_t addr, uint32_t& mapped_addr, uint8_t data) override;
+    void notify_pattern_fetch(uint16_t addr, uint64_t dot) override;
+
+    Mapper* clone() const override;
+    void reset() override;
+    bool mapped_to_prg_ram(uint16_t addr) override;
+    std::vector<uint8_t> get_prg_ram() override;
+
+    void save_state(StateWriter&) const override;
+    void load_state(StateReader&) override;
+
+    void update_banks();
+    void clock_irq_counter();
+};
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <vector>
+
+#include "mappers/Mapper.h"
+
+// Mapper 31: the bank switching of NSF music files, as a cartridge board.
+// Each 4 KB window of 0x8000 - 0xFFFF has its own bank register, at 0x5FF8 - 0x5FFF. CHR is 8 KB of RAM,
+// and PRG RAM at 0x6000 - 0x7FFF is there if the header asks for it (NSF files always get it, see NsfFile).
+// See https://www.nesdev.org/wiki/INES_Mapper_031
+struct Mapper031 final : Mapper {
+    static const uint16_t BANK_REGISTER_START = 0x5FF8;
+    static const uint32_t PRG_BANK_SIZE = 0x1000;
+
+    // The last window powers up as the last bank, so the CPU finds its vectors
+    uint8_t prg_banks[8] = {0, 0, 0, 0, 0, 0, 0, 0xFF};
+
+    Mapper031(uint16_t prg_rom_banks, size_t prg_ram_size, uint16_t chr_rom_banks) : Mapper(prg_rom_banks, (prg_ram_size + 0x1FFF) / 0x2000, chr_rom_banks, 0x2000) {
+        PRG_RAM = CowBuffer(prg_ram_size);
+    };
+
+    bool cpu_mapper_read(uint16_t addr, uint32_t& mapped_addr, uint8_t& data) override;
+    bool cpu_mapper_write(uint16_t addr, uint32_t& mapped_addr, uint8_t data) override;
+    bool ppu_mapper_read(uint16_t addr, uint32_t& mapped_addr) override;
+    bool ppu_mapper_write(uint16_t addr, uint32_t& mapped_addr, uint8_t data) override;
+
+    Mapper* clone() const override;
+    void reset() override;
+    bool mapped_to_prg_ram(uint16_t addr) override;
+    std::vector<uint8_t> get_prg_ram() override;
+
+    void save_state(StateWriter&) const override;
+    void load_state(StateReader&) override;
+};
@@ -0,0 +1,119 @@
+#pragma once
+
+/*
+    C interface for embedding the emulator.
+
+    Every nes_instance is fully independent: instances share no mutable state,
+    so a host can run different instances on different threads at the same time.
+    A single instance must not be used from two threads at once.
+
+    Functions which can fail return 0 on success and -1 on failure.
+    nes_get_last_error then describes what went wrong on that instance.
+
+    Pointers returned by the nes_get_* functions are borrowed. They stay valid until
+    the instance is destroyed or a new ROM is loaded, and their contents are updated in place
+    by nes_run_frame and nes_load_state.
+*/
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define NES_API_VERSION 1
+
+#define NES_SCREEN_WIDTH 256
+#define NES_SCREEN_HEIGHT 240
+#define NES_RAM_SIZE 2048
+
+// Button bits for nes_set_input
+#define NES_BUTTON_A      0x01
+#define NES_BUTTON_B      0x02
+#define NES_BUTTON_SELECT 0x04
+#define NES_BUTTON_START  0x08
+#define NES_BUTTON_UP     0x10
+#define NES_BUTTON_DOWN   0x20
+#define NES_BUTTON_LEFT   0x40
+#define NES_BUTTON_RIGHT  0x80
+
+typedef struct nes_instance nes_instance;
+
+int nes_api_version(void);
+
+nes_instance* nes_create(void);
+void nes_destroy(nes_instance* nes);
+
+// Load an iNES image. The data is copied, so the caller's buffer can be freed afterwards
+int nes_load_rom_from_memory(nes_instance* nes, const uint8_t* rom_data, size_t rom_size);
+
+// Run until the PPU finishes the current frame. Does not allocate
+int nes_run_frame(nes_instance* nes);
+
+// Only draw one frame in every frame_skip + 1 (0, the default, draws them all). Skipped frames run exactly the same,
+// sprite 0 hits and NMIs included, but the framebuffer keeps the last drawn frame. Carries over to ROMs loaded later
+int nes_set_frame_skip(nes_instance* nes, unsigned frame_skip);
+
+// Set the buttons held on controller port 1 or 2 (a mask of NES_BUTTON_* bits)
+int nes_set_input(nes_instance* nes, int port, uint8_t buttons);
+
+// Size of a save state for the loaded ROM, or 0 on error
+size_t nes_state_size(nes_instance* nes);
+
+// Write a save state into a caller-provided buffer of at least nes_state_size bytes
+int nes_save_state(nes_instance* nes, uint8_t* buffer, size_t buffer_size);
+int nes_load_state(nes_instance* nes, const uint8_t* buffer, size_t buffer_size);
+
+// NES_SCREEN_WIDTH * NES_SCREEN_HEIGHT color indices (0x00 - 0x3F), row-major
+const uint8_t* nes_get_framebuffer(nes_instance* nes);
+
+// RGBA value for each of the 64 color indices
+const uint32_t* nes_get_palette(void);
+
+// The NES_RAM_SIZE bytes of CPU work RAM. Writes go straight into the running machine
+uint8_t* nes_get_ram(nes_instance* nes);
+
+// 64-bit hashes of the framebuffer and of the whole machine state less the framebuffer, for spotting desyncs between
+// instances. Both are 0 without a ROM. With frame skip on, the frame hash is of the last frame drawn
+uint64_t nes_frame_hash(nes_instance* nes);
+uint64_t nes_state_hash(nes_instance* nes);
+
+// Signed 16-bit mono samples produced by the last nes_run_frame
+const int16_t* nes_get_audio_samples(nes_instance* nes, size_t* num_samples);
+
+const char* nes_get_last_error(nes_instance* nes);
+
+/*
+    Vectorized environment: num_envs copies of one ROM stepped together on a thread pool.
+    Every copy starts from the state reached after boot_frames frames, and is put back into it
+    after max_episode_frames frames (0 = never) or when nes_vec_reset is called.
+*/
+typedef struct nes_vec_env nes_vec_env;
+
+// Returns NULL if the ROM can't be loaded
+nes_vec_env* nes_vec_create(const uint8_t* rom_data, size_t rom_size, size_t num_envs, unsigned num_threads,
+                            uint64_t boot_frames, uint64_t max_episode_frames);
+void nes_vec_destroy(nes_vec_env* env);
+
+// inputs holds 2 bytes per environment: port 1 buttons, then port 2 buttons
+int nes_vec_step(nes_vec_env* env, const uint8_t* inputs);
+int nes_vec_reset(nes_vec_env* env, size_t index);
+
+// [num_envs x NES_SCREEN_HEIGHT x NES_SCREEN_WIDTH] color indices
+const uint8_t* nes_vec_observations(nes_vec_env* env);
+
+// [num_envs x NES_RAM_SIZE] CPU work RAM, copied out after every step
+const uint8_t* nes_vec_ram(nes_vec_env* env);
+
+// [num_envs] flags, 1 where the environment was reset at the end of the last step
+const uint8_t* nes_vec_dones(nes_vec_env* env);
+
+// Mean wall time of nes_vec_step and the total emulated frames per second
+void nes_vec_stats(nes_vec_env* env, double* mean_step_latency_us, double* frames_per_second);
+
+const char* nes_vec_get_last_error(nes_vec_env* env);
+
+#ifdef __cplusplus
+}
+#endif
@@ -3,16 +3,53 @@
 #include <chrono>
 #include <optional>
 #include <string>
+#include "APUWorker.h"
 #include "Bus.h"
 #include "Helpers.h"
-#include "RomPicker.h"
+#include "frontend/AudioStream.h"
+#include "frontend/KeyboardController.h"
+#include "frontend/RomPicker.h"
+#include "frontend/UI.h"
+
+// What sets the speed of emulation.
+// PACING_AUDIO: the sound card. Emulation blocks while the audio ring is full, which runs the NES at its own 60.0988 Hz
+// PACING_VSYNC: the display's refresh. Presenting a frame waits for vsync, and the audio rate control absorbs the difference
+// PACING_NONE: nothing, emulation runs as fast as it can and audio that doesn't fit is dropped
+enum PACING {PACING_AUDIO, PACING_VSYNC, PACING_NONE};
+
+// While Tab is held, emulation runs unpaced and only one frame in this many + 1 is drawn
+const uint32_t FAST_FORWARD_FRAME_SKIP = 7;
 
 int main(int argc, char** argv) {
 
     std::string rom_file;
-    if (argc >= 2) {
-        rom_file = argv[1];
-    } else {
+    PACING pacing = PACING_AUDIO;
+    uint32_t frame_skip = 0;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+
+        if (arg == "--pacing" && i + 1 < argc) {
+            std::string mode = argv[++i];
+
+            if (mode == "audio") {
+                pacing = PACING_AUDIO;
+            } else if (mode == "vsync") {
+                pacing = PACING_VSYNC;
+            } else if (mode == "none") {
+                pacing = PACING_NONE;
+            } else {
+                std::cout << "Usage: ./nesemu [rom] [--pacing audio|vsync|none] [--frame-skip N]" << std::endl;
+                return 1;
+            }
+        } else if (arg == "--frame-skip" && i + 1 < argc) {
+            frame_skip = std::stoul(argv[++i]);
+        } else {
+            rom_file = arg;
+        }
+    }
+
+    if (rom_file.empty()) {
         std::optional<std::string> picked = pick_rom_interactively("roms");
         if (!picked) {
             return 0;
@@ -23,19 +60,51 @@ int main(int argc, char** argv) {
     Bus nes = Bus();
     Cartridge* game = new Cartridge(rom_file);
 
+    // Battery saves live next to the ROM, as <game>.sav
+    game->attach_save_file("roms/" + rom_file.substr(0, rom_file.rfind('.')) + ".sav");
+
+    UI ui;
+    KeyboardController keyboard;
+    AudioStream audio;
+
+    // Audio is synthesized on its own thread, a frame behind emulation
+    APUWorker audio_worker(&audio);
+
+    audio.paces_emulation.store(pacing == PACING_AUDIO, std::memory_order_relaxed);
+    ui.window->setVerticalSyncEnabled(pacing == PACING_VSYNC);
+
+    nes.ppu->attach_video_output(&ui);
+    nes.ppu->set_frame_skip(frame_skip);
+    nes.apu->attach_worker(&audio_worker);
+    nes.io->connect_controller(&keyboard, 1);
     nes.insert_cartridge(game);
     nes.reset();
+    audio.play();
+
+    // Fast forward drops the pacing and draws fewer frames, and letting go of Tab restores both
+    bool is_fast_forwarding = false;
+
+    auto set_fast_forward = [&](bool fast_forward) {
+        is_fast_forwarding = fast_forward;
+        nes.ppu->set_frame_skip(fast_forward ? FAST_FORWARD_FRAME_SKIP : frame_skip);
+        audio.paces_emulation.store(!fast_forward && pacing == PACING_AUDIO, std::memory_order_relaxed);
+        ui.window->setVerticalSyncEnabled(!fast_forward && pacing == PACING_VSYNC);
+    };
 
     auto start = std::chrono::high_resolution_clock::now();
     int frame_count_start = 0;
     int cur_cycles = 0;    
 
-    while (nes.ppu->ui->window->isOpen()) {
+    while (ui.window->isOpen()) {
 
         sf::Event event;
-        while (cur_cycles % 300000 == 0 && nes.ppu->ui->window->pollEvent(event)) {
+        while (cur_cycles % 300000 == 0 && ui.window->pollEvent(event)) {
             if (event.type == sf::Event::Closed) {
-                nes.ppu->ui->window->close();
+                ui.window->close();
+            } else if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::Tab && !is_fast_forwarding) {
+                set_fast_forward(true);
+            } else if (event.type == sf::Event::KeyReleased && event.key.code == sf::Keyboard::Tab) {
+                set_fast_forward(false);
             }
         }
 
@@ -44,7 +113,10 @@ int main(int argc, char** argv) {
 
         // At 60 FPS each frame should be about 16666.6666... microseconds long
         if (elapsed_time > 16666) {
-            nes.ppu->ui->window->setTitle("FPS: " + std::to_string(1000000 * (nes.ppu->frames_elapsed - frame_count_start) / (double) elapsed_time));
+            ui.window->setTitle("FPS: " + std::to_string(1000000 * (nes.ppu->frames_elapsed - frame_count_start) / (double) elapsed_time) +
+                                " | Audio latency: " + std::to_string(static_cast<int>(audio.latency_ms())) + " ms" +
+                                " | Underruns: " + std::to_string(audio.underruns.load()) +
+                                (is_fast_forwarding ? " | Fast forward" : ""));
             start = std::chrono::high_resolution_clock::now();
             frame_count_start = nes.ppu->frames_elapsed;
         }
@@ -53,5 +125,10 @@ int main(int argc, char** argv) {
         cur_cycles++;
     }
 
+    nes.apu->attach_worker(nullptr);
+
+    // Syncs the save file, if there is one
+    delete game;
+
     return 0;
 }
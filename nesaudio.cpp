@@ -0,0 +1,136 @@
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+#include "Bus.h"
+#include "Movie.h"
+#include "NsfPlayer.h"
+#include "WavWriter.h"
+#include "controllers/VirtualController.h"
+
+using std::string;
+
+// Renders a game's or an NSF file's audio to a WAV file without a window or sound card, as fast as the emulator runs
+void print_usage() {
+    std::cout << "Usage: ./nesaudio <rom name in roms/> <output.wav> [--frames N] [--movie file.fm2]" << std::endl;
+    std::cout << "       ./nesaudio <nsf name in roms/> <output.wav> [--track N] [--seconds S]" << std::endl;
+    std::cout << "ROMs run N frames (600 by default), or the length of the movie." << std::endl;
+    std::cout << "NSF files play track N (the file's starting track by default) for S seconds (60 by default), without the PPU." << std::endl;
+}
+
+struct Options {
+    string input_file;
+    string output_file;
+    uint64_t frames = 600;
+    std::unique_ptr<Movie> movie;
+    int track = 0;
+    double seconds = 60;
+};
+
+bool is_nsf_file(const string& file_name) {
+    return file_name.size() > 4 && file_name.compare(file_name.size() - 4, 4, ".nsf") == 0;
+}
+
+// Returns the time taken to emulate, not counting the last of the writes to disk
+double render_rom(const Options& options, WavWriter& wav) {
+    Bus nes;
+    std::unique_ptr<Cartridge> game = std::make_unique<Cartridge>(options.input_file);
+    VirtualController port1;
+    VirtualController port2;
+
+    nes.io->connect_controller(&port1, 1);
+    nes.io->connect_controller(&port2, 2);
+    nes.apu->attach_audio_output(&wav);
+    nes.insert_cartridge(game.get());
+    nes.reset();
+
+    auto start = std::chrono::steady_clock::now();
+
+    for (uint64_t frame = 0; frame < options.frames; frame++) {
+        if (options.movie) {
+            port1.set_buttons(options.movie->port1_inputs.at(frame));
+            port2.set_buttons(options.movie->port2_inputs.at(frame));
+        }
+
+        nes.run_frame();
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    nes.apu->attach_audio_output(nullptr);
+    std::cout << "frames: " << options.frames << std::endl;
+    return seconds;
+}
+
+double render_nsf(const Options& options, WavWriter& wav) {
+    NsfPlayer player(options.input_file);
+    if (options.track > player.nsf.num_songs) {
+        throw std::runtime_error("NSF file has no track " + std::to_string(options.track) + ", it has " + std::to_string(player.nsf.num_songs));
+    }
+
+    uint8_t song = options.track > 0 ? options.track - 1 : player.nsf.starting_song;
+
+    std::cout << "name: " << player.nsf.name << ", artist: " << player.nsf.artist << ", copyright: " << player.nsf.copyright << std::endl;
+    std::cout << "track " << song + 1 << " of " << static_cast<int>(player.nsf.num_songs) << std::endl;
+
+    auto start = std::chrono::steady_clock::now();
+
+    player.nes.apu->attach_audio_output(&wav);
+    player.start_song(song);
+    player.run_seconds(options.seconds);
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    player.nes.apu->attach_audio_output(nullptr);
+    std::cout << "PLAY calls: " << player.num_play_calls << " (" << player.num_skipped_play_calls << " skipped)" << std::endl;
+    return seconds;
+}
+
+int main(int argc, char** argv) {
+
+    if (argc < 3) {
+        print_usage();
+        return 1;
+    }
+
+    Options options;
+    options.input_file = argv[1];
+    options.output_file = argv[2];
+
+    try {
+        for (int i = 3; i < argc; i++) {
+            string arg = argv[i];
+
+            if (arg == "--frames" && i + 1 < argc) {
+                options.frames = std::stoull(argv[++i]);
+            } else if (arg == "--movie" && i + 1 < argc) {
+                options.movie = std::make_unique<Movie>(argv[++i]);
+                options.frames = options.movie->num_frames();
+            } else if (arg == "--track" && i + 1 < argc) {
+                options.track = std::stoi(argv[++i]);
+            } else if (arg == "--seconds" && i + 1 < argc) {
+                options.seconds = std::stod(argv[++i]);
+            } else {
+                print_usage();
+                return 1;
+            }
+        }
+
+        WavWriter wav(options.output_file);
+        double seconds = is_nsf_file(options.input_file) ? render_nsf(options, wav) : render_rom(options, wav);
+        wav.close();
+
+        double audio_seconds = static_cast<double>(wav.samples_written) / AudioOutput::SAMPLE_RATE;
+
+        std::cout << "samples: " << wav.samples_written << " (" << audio_seconds << " s of audio)" << std::endl;
+        std::cout << "time: " << seconds << " s, " << (seconds > 0 ? audio_seconds / seconds : 0) << "x real time" << std::endl;
+        std::cout << "waits for the disk: " << wav.producer_waits << std::endl;
+    } catch (std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
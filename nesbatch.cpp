@@ -0,0 +1,248 @@
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "Bus.h"
+#include "Helpers.h"
+#include "Movie.h"
+#include "ThreadPool.h"
+#include "controllers/VirtualController.h"
+
+using std::string;
+using std::vector;
+
+// One line of the job file: a ROM, and either a frame count or an .fm2 movie to play back
+struct Job {
+    string rom_file;
+    string input;
+
+    uint64_t frames_run = 0;
+    double seconds = 0;
+
+    // Hash of the last frame, and a running hash over every frame of the run
+    uint64_t final_frame_hash = 0;
+    uint64_t all_frames_hash = HASH_SEED;
+
+    // Hash of the machine state after the last frame, see Bus::hash_state
+    uint64_t final_state_hash = 0;
+
+    string error;
+};
+
+bool is_number(const string& str) {
+    if (str.empty()) {
+        return false;
+    }
+
+    for (char c : str) {
+        if (c < '0' || c > '9') {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+vector<Job> load_jobs(const string& job_file_name) {
+    std::ifstream job_file(job_file_name);
+
+    if (!job_file.is_open()) {
+        throw std::runtime_error("Failed to open job file " + job_file_name);
+    }
+
+    vector<Job> jobs;
+    string line;
+
+    while (std::getline(job_file, line)) {
+        std::stringstream line_stream(line);
+        Job job;
+
+        // Skip blank lines and comments
+        if (!(line_stream >> job.rom_file) || job.rom_file[0] == '#') {
+            continue;
+        }
+
+        if (!(line_stream >> job.input)) {
+            throw std::runtime_error("Job for " + job.rom_file + " needs a frame count or a movie file");
+        }
+
+        jobs.push_back(job);
+    }
+
+    return jobs;
+}
+
+void run_job(Job& job) {
+    auto start = std::chrono::steady_clock::now();
+
+    try {
+        std::unique_ptr<Movie> movie;
+        uint64_t num_frames;
+
+        if (is_number(job.input)) {
+            num_frames = std::stoull(job.input);
+        } else {
+            movie = std::make_unique<Movie>(job.input);
+            num_frames = movie->num_frames();
+        }
+
+        // Every job gets its own headless instance and controllers, nothing is shared between threads
+        Bus nes;
+        std::unique_ptr<Cartridge> game = std::make_unique<Cartridge>(job.rom_file);
+        VirtualController port1;
+        VirtualController port2;
+
+        nes.io->connect_controller(&port1, 1);
+        nes.io->connect_controller(&port2, 2);
+        nes.insert_cartridge(game.get());
+        nes.reset();
+
+        for (uint64_t frame = 0; frame < num_frames; frame++) {
+            if (movie) {
+                port1.set_buttons(movie->port1_inputs.at(frame));
+                port2.set_buttons(movie->port2_inputs.at(frame));
+            }
+
+            nes.run_frame();
+
+            job.final_frame_hash = nes.hash_frame();
+            job.all_frames_hash = hash_bytes(reinterpret_cast<const uint8_t*>(&job.final_frame_hash), sizeof(uint64_t), job.all_frames_hash);
+            job.frames_run++;
+        }
+
+        job.final_state_hash = nes.hash_state();
+    } catch (std::exception& e) {
+        job.error = e.what();
+    }
+
+    job.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+string json_string(const string& str) {
+    string res = "\"";
+
+    for (char c : str) {
+        if (c == '"' || c == '\\') {
+            res += '\\';
+            res += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            char escaped[8];
+            std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+            res += escaped;
+        } else {
+            res += c;
+        }
+    }
+
+    return res + "\"";
+}
+
+string hash_string(uint64_t hash) {
+    char buffer[17];
+    std::snprintf(buffer, sizeof(buffer), "%016llx", static_cast<unsigned long long>(hash));
+    return buffer;
+}
+
+void write_report(std::ostream& out, const vector<Job>& jobs, size_t num_threads, double wall_seconds) {
+    uint64_t total_frames = 0;
+
+    for (const Job& job : jobs) {
+        total_frames += job.frames_run;
+    }
+
+    out << "{\n";
+    out << "  \"threads\": " << num_threads << ",\n";
+    out << "  \"wall_seconds\": " << wall_seconds << ",\n";
+    out << "  \"total_frames\": " << total_frames << ",\n";
+    out << "  \"frames_per_second\": " << (wall_seconds > 0 ? total_frames / wall_seconds : 0) << ",\n";
+    out << "  \"jobs\": [\n";
+
+    for (size_t i = 0; i < jobs.size(); i++) {
+        const Job& job = jobs.at(i);
+
+        out << "    {";
+        out << "\"rom\": " << json_string(job.rom_file) << ", ";
+        out << "\"input\": " << json_string(job.input) << ", ";
+        out << "\"frames\": " << job.frames_run << ", ";
+        out << "\"seconds\": " << job.seconds << ", ";
+        out << "\"frames_per_second\": " << (job.seconds > 0 ? job.frames_run / job.seconds : 0) << ", ";
+        out << "\"final_frame_hash\": \"" << hash_string(job.final_frame_hash) << "\", ";
+        out << "\"all_frames_hash\": \"" << hash_string(job.all_frames_hash) << "\", ";
+        out << "\"final_state_hash\": \"" << hash_string(job.final_state_hash) << "\", ";
+        out << "\"error\": " << (job.error.empty() ? "null" : json_string(job.error));
+        out << "}" << (i + 1 < jobs.size() ? "," : "") << "\n";
+    }
+
+    out << "  ]\n";
+    out << "}\n";
+}
+
+int main(int argc, char** argv) {
+
+    if (argc < 2) {
+        std::cout << "Usage: ./nesbatch <job file> [output json] [--threads N]" << std::endl;
+        std::cout << "Each job file line is: <rom name in roms/> <frame count | movie.fm2>" << std::endl;
+        return 1;
+    }
+
+    string job_file_name;
+    string output_file_name;
+    unsigned num_threads = 0;
+
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+
+        if (arg == "--threads" && i + 1 < argc) {
+            num_threads = std::stoul(argv[++i]);
+        } else if (job_file_name.empty()) {
+            job_file_name = arg;
+        } else {
+            output_file_name = arg;
+        }
+    }
+
+    vector<Job> jobs;
+
+    try {
+        jobs = load_jobs(job_file_name);
+    } catch (std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    size_t pool_size;
+
+    {
+        ThreadPool pool(num_threads);
+        pool_size = pool.size();
+
+        for (Job& job : jobs) {
+            pool.submit([&job] { run_job(job); });
+        }
+
+        pool.wait_idle();
+    }
+
+    double wall_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    if (output_file_name.empty()) {
+        write_report(std::cout, jobs, pool_size, wall_seconds);
+    } else {
+        std::ofstream output_file(output_file_name);
+        write_report(output_file, jobs, pool_size, wall_seconds);
+    }
+
+    for (const Job& job : jobs) {
+        if (!job.error.empty()) {
+            return 1;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,744 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "APUWorker.h"
+#include "AudioOutput.h"
+#include "BlipBuffer.h"
+#include "Bus.h"
+#include "Helpers.h"
+
+using std::string;
+using std::vector;
+
+// Count heap allocations, so benchmarks can report how much memory an operation costs.
+// Every form of new and delete is replaced, so each allocation and its release go through the same malloc/free pair
+static std::atomic<uint64_t> bytes_allocated{0};
+
+static void* counted_alloc(size_t size, size_t alignment = 0) {
+    bytes_allocated += size;
+
+    if (size == 0) {
+        size = 1;
+    }
+
+    // aligned_alloc wants a size which is a multiple of the alignment
+    void* ptr = alignment == 0 ? std::malloc(size) : std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+
+    if (ptr == nullptr) {
+        throw std::bad_alloc();
+    }
+
+    return ptr;
+}
+
+static void* counted_alloc_nothrow(size_t size, size_t alignment = 0) noexcept {
+    try {
+        return counted_alloc(size, alignment);
+    } catch (std::bad_alloc&) {
+        return nullptr;
+    }
+}
+
+void* operator new(size_t size) {
+    return counted_alloc(size);
+}
+
+void* operator new[](size_t size) {
+    return counted_alloc(size);
+}
+
+void* operator new(size_t size, std::align_val_t alignment) {
+    return counted_alloc(size, static_cast<size_t>(alignment));
+}
+
+void* operator new[](size_t size, std::align_val_t alignment) {
+    return counted_alloc(size, static_cast<size_t>(alignment));
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    return counted_alloc_nothrow(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+    return counted_alloc_nothrow(size);
+}
+
+void* operator new(size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return counted_alloc_nothrow(size, static_cast<size_t>(alignment));
+}
+
+void* operator new[](size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return counted_alloc_nothrow(size, static_cast<size_t>(alignment));
+}
+
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr, size_t) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::align_val_t) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr, std::align_val_t) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, size_t, std::align_val_t) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr, size_t, std::align_val_t) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, const std::nothrow_t&) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::align_val_t, const std::nothrow_t&) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr, std::align_val_t, const std::nothrow_t&) noexcept {
+    std::free(ptr);
+}
+
+struct Options {
+    string rom_file;
+
+    // Frames to run before measuring
+    uint64_t frames = 60;
+
+    // How many times to repeat the measured operation
+    uint64_t count = 1000;
+};
+
+double seconds_since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// A machine with a cartridge inserted, booted for the given number of frames
+struct Instance {
+    std::unique_ptr<Cartridge> cartridge;
+    Bus bus;
+
+    Instance(const string& rom_file, uint64_t frames) {
+        cartridge = std::make_unique<Cartridge>(rom_file);
+        bus.insert_cartridge(cartridge.get());
+        bus.reset();
+
+        for (uint64_t i = 0; i < frames; i++) {
+            bus.run_frame();
+        }
+    }
+};
+
+uint64_t hash_machine(const Bus& nes) {
+    uint64_t hash = hash_bytes(nes.ppu->screen.pixels.data(), nes.ppu->screen.pixels.size());
+    return hash_bytes(nes.cpu_RAM.data(), nes.cpu_RAM.size(), hash);
+}
+
+// Cost of Bus::clone() in time and memory, compared with restoring a save state into a fresh machine
+int bench_clone(const Options& options) {
+    Instance original(options.rom_file, options.frames);
+
+    // Time clones which are thrown away straight after, like the save state loop below
+    auto start = std::chrono::steady_clock::now();
+
+    for (uint64_t i = 0; i < options.count; i++) {
+        std::unique_ptr<Bus> clone = original.bus.clone();
+    }
+
+    double clone_seconds = seconds_since(start);
+
+    // Memory is measured on clones which are kept alive
+    vector<std::unique_ptr<Bus>> clones;
+    clones.reserve(options.count);
+
+    uint64_t bytes_before = bytes_allocated;
+
+    for (uint64_t i = 0; i < options.count; i++) {
+        clones.push_back(original.bus.clone());
+    }
+
+    uint64_t clone_bytes = bytes_allocated - bytes_before;
+
+    // Running a frame makes every clone write to its own copy of the shared buffers it touches
+    bytes_before = bytes_allocated;
+
+    for (std::unique_ptr<Bus>& clone : clones) {
+        clone->run_frame();
+    }
+
+    uint64_t detach_bytes = bytes_allocated - bytes_before;
+
+    // The alternative: build a new machine and load a save state into it
+    vector<uint8_t> state;
+    original.bus.save_state(state);
+
+    start = std::chrono::steady_clock::now();
+
+    for (uint64_t i = 0; i < options.count; i++) {
+        Cartridge cartridge(*original.cartridge);
+        Bus nes;
+        nes.insert_cartridge(&cartridge);
+        nes.load_state(state.data(), state.size());
+    }
+
+    double state_seconds = seconds_since(start);
+
+    // A clone must behave exactly like the machine it was cloned from
+    std::unique_ptr<Bus> clone = original.bus.clone();
+
+    for (uint64_t i = 0; i < options.frames; i++) {
+        original.bus.run_frame();
+        clone->run_frame();
+    }
+
+    bool matches = hash_machine(original.bus) == hash_machine(*clone);
+
+    std::cout << "clone: " << options.count << " clones of " << options.rom_file << " after " << options.frames << " frames" << std::endl;
+    std::cout << "  clone:                          " << 1e6 * clone_seconds / options.count << " us" << std::endl;
+    std::cout << "  memory per clone:               " << clone_bytes / 1024.0 / options.count << " KB" << std::endl;
+    std::cout << "  copied on write after 1 frame:  " << detach_bytes / 1024.0 / options.count << " KB" << std::endl;
+    std::cout << "  new machine + load_state:       " << 1e6 * state_seconds / options.count << " us" << std::endl;
+    std::cout << "  clone matches original:         " << (matches ? "yes" : "NO") << std::endl;
+
+    return matches ? 0 : 1;
+}
+
+// Time to the first frame of a forked worker (see nesforkserver), compared with starting from scratch
+int bench_fork(const Options& options) {
+    // Cold start: load the ROM, boot, then run the first frame of the job
+    auto start = std::chrono::steady_clock::now();
+
+    for (uint64_t i = 0; i < options.count; i++) {
+        Instance cold(options.rom_file, options.frames);
+        cold.bus.run_frame();
+    }
+
+    double cold_seconds = seconds_since(start);
+
+    // Forked: the parent boots once, and each child runs its first frame straight away
+    Instance booted(options.rom_file, options.frames);
+    std::cout.flush();
+
+    start = std::chrono::steady_clock::now();
+
+    for (uint64_t i = 0; i < options.count; i++) {
+        int result_pipe[2];
+
+        if (pipe(result_pipe) < 0) {
+            throw std::runtime_error("Failed to create pipe");
+        }
+
+        pid_t pid = fork();
+
+        if (pid < 0) {
+            throw std::runtime_error("fork failed");
+        }
+
+        if (pid == 0) {
+            booted.bus.run_frame();
+
+            uint8_t done = 1;
+            ssize_t res = write(result_pipe[1], &done, 1);
+            _exit(res == 1 ? 0 : 1);
+        }
+
+        // The frame is done once the child reports back
+        uint8_t done;
+
+        if (read(result_pipe[0], &done, 1) != 1) {
+            throw std::runtime_error("Worker failed");
+        }
+
+        close(result_pipe[0]);
+        close(result_pipe[1]);
+        waitpid(pid, nullptr, 0);
+    }
+
+    double fork_seconds = seconds_since(start);
+
+    std::cout << "fork: " << options.count << " workers of " << options.rom_file << " booted to frame " << options.frames << std::endl;
+    std::cout << "  cold start to first frame:      " << 1e6 * cold_seconds / options.count << " us" << std::endl;
+    std::cout << "  forked worker to first frame:   " << 1e6 * fork_seconds / options.count << " us" << std::endl;
+
+    return 0;
+}
+
+// Memory per instance when many instances of one ROM run in the same process
+int bench_instances(const Options& options) {
+    std::ifstream rom_file("roms/" + options.rom_file, std::ios::binary);
+
+    if (!rom_file.is_open()) {
+        throw std::runtime_error("Failed to open roms/" + options.rom_file);
+    }
+
+    vector<uint8_t> rom_data((std::istreambuf_iterator<char>(rom_file)), std::istreambuf_iterator<char>());
+
+    vector<std::unique_ptr<Cartridge>> cartridges;
+    vector<std::unique_ptr<Bus>> instances;
+    cartridges.reserve(options.count);
+    instances.reserve(options.count);
+
+    uint64_t bytes_before = bytes_allocated;
+    auto start = std::chrono::steady_clock::now();
+
+    for (uint64_t i = 0; i < options.count; i++) {
+        cartridges.push_back(std::make_unique<Cartridge>(rom_data.data(), rom_data.size()));
+        instances.push_back(std::make_unique<Bus>());
+        instances.back()->insert_cartridge(cartridges.back().get());
+        instances.back()->reset();
+    }
+
+    double seconds = seconds_since(start);
+    uint64_t instance_bytes = bytes_allocated - bytes_before;
+
+    const RomImage& image = *cartridges.front()->rom;
+    size_t rom_size = image.PRG_ROM.size() + image.CHR_ROM.size();
+
+    std::cout << "instances: " << options.count << " instances of " << options.rom_file << std::endl;
+    std::cout << "  ROM images loaded:              " << RomImage::num_loaded() << " (" << rom_size / 1024.0 << " KB each)" << std::endl;
+    std::cout << "  memory per instance:            " << instance_bytes / 1024.0 / options.count << " KB" << std::endl;
+    std::cout << "  of which framebuffer:           " << instances.front()->ppu->screen.pixels.size() / 1024.0 << " KB" << std::endl;
+    std::cout << "  create + reset:                 " << 1e6 * seconds / options.count << " us" << std::endl;
+
+    return 0;
+}
+
+// PRG ROM reads through the cartridge's page table, compared with asking the mapper on every read
+int bench_mapper(const Options& options) {
+    Instance instance(options.rom_file, options.frames);
+    Cartridge& cartridge = *instance.cartridge;
+
+    // Both paths must agree on every address
+    bool matches = true;
+
+    for (uint32_t address = 0x8000; address <= 0xFFFF; address++) {
+        uint8_t from_table;
+        uint8_t from_mapper;
+
+        cartridge.read_cpu(address, from_table);
+        cartridge.read_prg_through_mapper(address, from_mapper);
+
+        matches &= from_table == from_mapper;
+    }
+
+    // Sum the bytes read so the loops can't be optimized away
+    uint64_t table_sum = 0;
+    uint64_t mapper_sum = 0;
+
+    auto start = std::chrono::steady_clock::now();
+
+    for (uint64_t i = 0; i < options.count; i++) {
+        for (uint32_t address = 0x8000; address <= 0xFFFF; address++) {
+            uint8_t data;
+            cartridge.read_cpu(address, data);
+            table_sum += data;
+        }
+    }
+
+    double table_seconds = seconds_since(start);
+    start = std::chrono::steady_clock::now();
+
+    for (uint64_t i = 0; i < options.count; i++) {
+        for (uint32_t address = 0x8000; address <= 0xFFFF; address++) {
+            uint8_t data;
+            cartridge.read_prg_through_mapper(address, data);
+            mapper_sum += data;
+        }
+    }
+
+    double mapper_seconds = seconds_since(start);
+
+    start = std::chrono::steady_clock::now();
+
+    for (uint64_t i = 0; i < options.frames; i++) {
+        instance.bus.run_frame();
+    }
+
+    double frame_seconds = seconds_since(start);
+    double num_reads = 0x8000 * static_cast<double>(options.count);
+
+    std::cout << "mapper: mapper " << cartridge.header.mapper_number << " (" << options.rom_file << ")" << std::endl;
+    std::cout << "  page table read:                " << 1e9 * table_seconds / num_reads << " ns" << std::endl;
+    std::cout << "  virtual mapper read:            " << 1e9 * mapper_seconds / num_reads << " ns" << std::endl;
+    std::cout << "  frames per second:              " << options.frames / frame_seconds << std::endl;
+    std::cout << "  paths agree:                    " << (matches && table_sum == mapper_sum ? "yes" : "NO") << std::endl;
+
+    return matches && table_sum == mapper_sum ? 0 : 1;
+}
+
+// Discards the samples, keeping a hash so runs can be compared
+struct HashingAudioOutput : AudioOutput {
+    uint64_t hash = HASH_SEED;
+    uint64_t num_samples = 0;
+
+    void write_samples(const int16_t* samples, size_t count) override {
+        hash = hash_bytes(reinterpret_cast<const uint8_t*>(samples), count * sizeof(int16_t), hash);
+        num_samples += count;
+    }
+};
+
+struct APURun {
+    double seconds;
+    uint64_t audio_hash;
+    uint64_t num_samples;
+};
+
+// Run the ROM from power on with audio attached and the APU driven the given way, timing the measured frames.
+// With a worker, the samples are synthesized on its thread, and the time includes waiting for it to finish
+APURun run_apu(const Options& options, APU_SCHEDULING scheduling, bool use_worker = false) {
+    Cartridge cartridge(options.rom_file);
+    HashingAudioOutput audio;
+    std::unique_ptr<APUWorker> worker;
+    Bus nes;
+
+    nes.apu->scheduling = scheduling;
+
+    if (use_worker) {
+        worker = std::make_unique<APUWorker>(&audio);
+        nes.apu->attach_worker(worker.get());
+    } else {
+        nes.apu->attach_audio_output(&audio);
+    }
+
+    nes.insert_cartridge(&cartridge);
+    nes.reset();
+
+    for (uint64_t i = 0; i < options.frames; i++) {
+        nes.run_frame();
+    }
+
+    auto start = std::chrono::steady_clock::now();
+
+    for (uint64_t i = 0; i < options.count; i++) {
+        nes.run_frame();
+    }
+
+    // Samples up to the current cycle, the same as the APU has handed over when it runs on this thread
+    if (use_worker) {
+        nes.apu->catch_up();
+        nes.apu->attach_worker(nullptr);
+    }
+
+    return {seconds_since(start), audio.hash, audio.num_samples};
+}
+
+// Share of frame time spent in the APU when it is caught up every CPU cycle, compared with only on events,
+// and with synthesis moved to a worker thread
+int bench_apu(const Options& options) {
+    APURun disabled = run_apu(options, APU_DISABLED);
+    APURun every_cycle = run_apu(options, APU_EVERY_CYCLE);
+    APURun on_events = run_apu(options, APU_ON_EVENTS);
+    APURun on_worker = run_apu(options, APU_ON_EVENTS, true);
+
+    // Every way of driving the APU must produce exactly the same audio
+    bool matches = every_cycle.audio_hash == on_events.audio_hash && every_cycle.num_samples == on_events.num_samples;
+    matches = matches && on_worker.audio_hash == on_events.audio_hash && on_worker.num_samples == on_events.num_samples;
+
+    auto frame_us = [&](const APURun& run) {
+        return 1e6 * run.seconds / options.count;
+    };
+
+    // The APU's share is the time a frame takes over a machine whose APU never runs
+    auto apu_share = [&](const APURun& run) {
+        return 100 * (run.seconds - disabled.seconds) / run.seconds;
+    };
+
+    std::cout << "apu: " << options.count << " frames of " << options.rom_file << " after " << options.frames << " frames, with audio" << std::endl;
+    std::cout << "  frame, APU disabled:            " << frame_us(disabled) << " us" << std::endl;
+    std::cout << "  frame, APU every cycle:         " << frame_us(every_cycle) << " us (APU " << apu_share(every_cycle) << "%)" << std::endl;
+    std::cout << "  frame, APU on events:           " << frame_us(on_events) << " us (APU " << apu_share(on_events) << "%)" << std::endl;
+    std::cout << "  frame, APU on a worker thread:  " << frame_us(on_worker) << " us (APU " << apu_share(on_worker) << "%)" << std::endl;
+    std::cout << "  samples per frame:              " << static_cast<double>(on_events.num_samples) / (options.frames + options.count) << std::endl;
+    std::cout << "  audio matches:                  " << (matches ? "yes" : "NO") << std::endl;
+
+    return matches ? 0 : 1;
+}
+
+// The channels' outputs at a CPU cycle where one of them changed
+struct MixerInput {
+    uint32_t cycle;
+    uint8_t pulse_1;
+    uint8_t pulse_2;
+    uint8_t triangle;
+    uint8_t noise;
+    uint8_t dmc;
+};
+
+// Every change of the mixer's inputs while the ROM runs the given number of frames from power on
+vector<MixerInput> record_mixer_inputs(const Options& options) {
+    Cartridge cartridge(options.rom_file);
+    Bus nes;
+
+    nes.insert_cartridge(&cartridge);
+    nes.reset();
+
+    vector<MixerInput> inputs;
+    MixerInput last = {};
+    uint64_t last_cpu_cycle = 0;
+
+    while (nes.ppu->frames_elapsed < options.frames) {
+        nes.tick();
+
+        if (nes.num_cpu_cycles == last_cpu_cycle) {
+            continue;
+        }
+
+        last_cpu_cycle = nes.num_cpu_cycles;
+        nes.apu->catch_up();
+
+        const APU& apu = *nes.apu;
+        MixerInput input = {static_cast<uint32_t>(last_cpu_cycle), apu.pulse_channel_1.output(), apu.pulse_channel_2.output(),
+                            apu.triangle_channel.output(), apu.noise_channel.output(), apu.dmc_channel.output_level};
+
+        if (input.pulse_1 != last.pulse_1 || input.pulse_2 != last.pulse_2 || input.triangle != last.triangle ||
+            input.noise != last.noise || input.dmc != last.dmc) {
+            inputs.push_back(input);
+            last = input;
+        }
+    }
+
+    return inputs;
+}
+
+// The mixer formulas the lookup tables replace
+int mix_with_formulas(const MixerInput& input) {
+    float pulse_sum = input.pulse_1 + input.pulse_2;
+    float pulse_out = pulse_sum == 0 ? 0 : 95.88f / (8128.0f / pulse_sum + 100.0f);
+
+    float tnd_sum = input.triangle / 8227.0f + input.noise / 12241.0f + input.dmc / 22638.0f;
+    float tnd_out = tnd_sum == 0 ? 0 : 159.79f / (1.0f / tnd_sum + 100.0f);
+
+    return static_cast<int>((pulse_out + tnd_out) * APU::OUTPUT_SCALE);
+}
+
+struct ResamplerRun {
+    double seconds;
+    vector<int16_t> samples;
+};
+
+// Resample the amplitude changes count times over, the way the APU does: a block of deltas, then read the finished samples.
+// Only the last pass's samples are kept
+template <typename AddDelta>
+ResamplerRun run_resampler(const vector<std::pair<uint32_t, int>>& deltas, uint64_t count, AddDelta add_delta) {
+    BlipBuffer blip_buffer(APU::CPU_CLOCK_RATE, AudioOutput::SAMPLE_RATE, 2 * AudioOutput::SAMPLE_RATE / 60);
+    vector<int16_t> block(2 * AudioOutput::SAMPLE_RATE / 60);
+    ResamplerRun run = {0, {}};
+
+    auto start = std::chrono::steady_clock::now();
+
+    for (uint64_t pass = 0; pass < count; pass++) {
+        run.samples.clear();
+        blip_buffer.clear();
+
+        uint32_t block_start = 0;
+        size_t next = 0;
+
+        while (next < deltas.size()) {
+            uint32_t block_end = block_start + APU::BLOCK_CYCLES;
+
+            for (; next < deltas.size() && deltas[next].first < block_end; next++) {
+                add_delta(blip_buffer, deltas[next].first - block_start, deltas[next].second);
+            }
+
+            blip_buffer.end_block(APU::BLOCK_CYCLES);
+            size_t num_samples = blip_buffer.read_samples(block.data(), block.size());
+            run.samples.insert(run.samples.end(), block.begin(), block.begin() + num_samples);
+
+            block_start = block_end;
+        }
+    }
+
+    run.seconds = seconds_since(start);
+    return run;
+}
+
+// Throughput of the mixer's lookup tables and of the resampler's vectorized and scalar paths, on the ROM's own audio
+int bench_mixer(const Options& options) {
+    vector<MixerInput> inputs = record_mixer_inputs(options);
+
+    if (inputs.empty()) {
+        throw std::runtime_error("The ROM made no sound in " + std::to_string(options.frames) + " frames");
+    }
+
+    // Mix every recorded input count times over, through the tables and through the formulas
+    uint64_t table_sum = 0;
+    auto start = std::chrono::steady_clock::now();
+
+    for (uint64_t pass = 0; pass < options.count; pass++) {
+        for (const MixerInput& input : inputs) {
+            table_sum += APU::mix_levels(input.pulse_1, input.pulse_2, input.triangle, input.noise, input.dmc);
+        }
+    }
+
+    double table_seconds = seconds_since(start);
+
+    uint64_t formula_sum = 0;
+    start = std::chrono::steady_clock::now();
+
+    for (uint64_t pass = 0; pass < options.count; pass++) {
+        for (const MixerInput& input : inputs) {
+            formula_sum += mix_with_formulas(input);
+        }
+    }
+
+    double formula_seconds = seconds_since(start);
+
+    // Keep the sums, so the loops aren't optimized away
+    volatile uint64_t mixed_sum = table_sum + formula_sum;
+    (void)mixed_sum;
+
+    // How far the tables' approximation of the triangle, noise and DMC weights strays, relative to full scale
+    int max_error = 0;
+
+    for (const MixerInput& input : inputs) {
+        int error = APU::mix_levels(input.pulse_1, input.pulse_2, input.triangle, input.noise, input.dmc) - mix_with_formulas(input);
+        max_error = std::max(max_error, std::abs(error));
+    }
+
+    // The amplitude changes the APU would hand the resampler
+    vector<std::pair<uint32_t, int>> deltas;
+    int last_amplitude = 0;
+
+    for (const MixerInput& input : inputs) {
+        int amplitude = APU::mix_levels(input.pulse_1, input.pulse_2, input.triangle, input.noise, input.dmc);
+
+        if (amplitude != last_amplitude) {
+            deltas.push_back({input.cycle, amplitude - last_amplitude});
+            last_amplitude = amplitude;
+        }
+    }
+
+    ResamplerRun vector_run = run_resampler(deltas, options.count, [](BlipBuffer& buffer, uint32_t time, int delta) {
+        buffer.add_delta(time, delta);
+    });
+
+    ResamplerRun sse2_run = run_resampler(deltas, options.count, [](BlipBuffer& buffer, uint32_t time, int delta) {
+        buffer.add_delta_sse2(time, delta);
+    });
+
+    ResamplerRun scalar_run = run_resampler(deltas, options.count, [](BlipBuffer& buffer, uint32_t time, int delta) {
+        buffer.add_delta_scalar(time, delta);
+    });
+
+    // Without fused multiply-adds all paths round the same way. With them, samples may be 1 apart
+    bool matches = vector_run.samples.size() == scalar_run.samples.size() && sse2_run.samples.size() == scalar_run.samples.size();
+    int max_sample_difference = 0;
+
+    for (size_t i = 0; matches && i < scalar_run.samples.size(); i++) {
+        max_sample_difference = std::max(max_sample_difference, std::abs(vector_run.samples[i] - scalar_run.samples[i]));
+        max_sample_difference = std::max(max_sample_difference, std::abs(sse2_run.samples[i] - scalar_run.samples[i]));
+    }
+
+    matches = matches && max_sample_difference <= 1;
+
+    double num_mixes = static_cast<double>(inputs.size()) * options.count;
+    double num_samples = static_cast<double>(vector_run.samples.size()) * options.count;
+
+    std::cout << "mixer: " << options.frames << " frames of " << options.rom_file << ", mixed and resampled " << options.count << " times" << std::endl;
+    std::cout << "  mixer input changes:            " << inputs.size() << " (" << deltas.size() << " amplitude changes)" << std::endl;
+    std::cout << "  mixes per second, tables:       " << num_mixes / table_seconds << std::endl;
+    std::cout << "  mixes per second, formulas:     " << num_mixes / formula_seconds << std::endl;
+    std::cout << "  tables' largest error:          " << max_error << " (" << 100.0 * max_error / APU::OUTPUT_SCALE << "% of full scale)" << std::endl;
+    std::cout << "  samples per second, vector:     " << num_samples / vector_run.seconds << " (" << BlipBuffer::vector_extension() << ")" << std::endl;
+    std::cout << "  samples per second, SSE2:       " << num_samples / sse2_run.seconds << std::endl;
+    std::cout << "  samples per second, scalar:     " << num_samples / scalar_run.seconds << std::endl;
+    std::cout << "  paths agree:                    " << (matches ? "yes" : "NO") << std::endl;
+
+    return matches ? 0 : 1;
+}
+
+struct Benchmark {
+    const char* name;
+    const char* description;
+    int (*run)(const Options&);
+};
+
+const Benchmark BENCHMARKS[] = {
+    {"clone", "time and memory cost of Bus::clone()", bench_clone},
+    {"instances", "memory per instance with many instances of one ROM", bench_instances},
+    {"mapper", "PRG ROM reads through the page table compared with virtual mapper calls", bench_mapper},
+    {"apu", "share of frame time spent in the APU, caught up every cycle, only on events, and on a worker thread", bench_apu},
+    {"mixer", "mixer lookup tables and resampler throughput in samples per second, on the ROM's audio", bench_mixer},
+    {"fork", "time to first frame of a forked worker compared with a cold start", bench_fork},
+};
+
+void print_usage() {
+    std::cout << "Usage: ./nesbench <benchmark> <rom name in roms/> [--frames N] [--count N]" << std::endl;
+    std::cout << "Benchmarks:" << std::endl;
+
+    for (const Benchmark& benchmark : BENCHMARKS) {
+        std::cout << "  " << benchmark.name << ": " << benchmark.description << std::endl;
+    }
+}
+
+int main(int argc, char** argv) {
+
+    if (argc < 3) {
+        print_usage();
+        return 1;
+    }
+
+    string benchmark_name = argv[1];
+    Options options;
+    options.rom_file = argv[2];
+
+    for (int i = 3; i < argc; i++) {
+        string arg = argv[i];
+
+        if (arg == "--frames" && i + 1 < argc) {
+            options.frames = std::stoull(argv[++i]);
+        } else if (arg == "--count" && i + 1 < argc) {
+            options.count = std::stoull(argv[++i]);
+        } else {
+            print_usage();
+            return 1;
+        }
+    }
+
+    for (const Benchmark& benchmark : BENCHMARKS) {
+        if (benchmark_name == benchmark.name) {
+            try {
+                return benchmark.run(options);
+            } catch (std::exception& e) {
+                std::cerr << e.what() << std::endl;
+                return 1;
+            }
+        }
+    }
+
+    print_usage();
+    return 1;
+}
@@ -0,0 +1,280 @@
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "Bus.h"
+#include "Helpers.h"
+#include "Movie.h"
+#include "controllers/VirtualController.h"
+
+using std::string;
+
+/*
+    Fork server: boot a ROM once, then fork() a worker for every request.
+    Workers inherit the booted machine through copy-on-write pages, so they start
+    running frames straight away instead of loading the ROM and running the boot frames again.
+
+    Requests are one line on a Unix domain socket: "<frames> [movie.fm2]".
+    The worker answers with a line after its first frame, then a line when it is done:
+        first_frame_us <microseconds since the request was accepted>
+        done frames=<n> hash=<final frame hash> seconds=<time spent running>
+    or "error <message>" if something went wrong.
+*/
+
+// The booted machine every worker starts from
+struct Server {
+    std::unique_ptr<Cartridge> cartridge;
+    Bus nes;
+    VirtualController port1;
+    VirtualController port2;
+};
+
+bool write_line(int fd, const string& line) {
+    string data = line + "\n";
+    size_t written = 0;
+
+    while (written < data.size()) {
+        ssize_t res = write(fd, data.data() + written, data.size() - written);
+
+        if (res <= 0) {
+            return false;
+        }
+
+        written += res;
+    }
+
+    return true;
+}
+
+bool read_line(int fd, string& line) {
+    line.clear();
+    char c;
+
+    while (read(fd, &c, 1) == 1) {
+        if (c == '\n') {
+            return true;
+        }
+
+        line += c;
+    }
+
+    return !line.empty();
+}
+
+string hash_string(uint64_t hash) {
+    char buffer[17];
+    std::snprintf(buffer, sizeof(buffer), "%016llx", static_cast<unsigned long long>(hash));
+    return buffer;
+}
+
+// Runs in the forked worker
+void serve_request(Server& server, int client, std::chrono::steady_clock::time_point accepted) {
+    string request;
+
+    if (!read_line(client, request)) {
+        return;
+    }
+
+    try {
+        std::stringstream request_stream(request);
+        uint64_t num_frames = 0;
+        string movie_file;
+
+        if (!(request_stream >> num_frames)) {
+            throw std::runtime_error("Request must start with a frame count");
+        }
+
+        std::unique_ptr<Movie> movie;
+
+        if (request_stream >> movie_file) {
+            movie = std::make_unique<Movie>(movie_file);
+            num_frames = std::min<uint64_t>(num_frames, movie->num_frames());
+        }
+
+        auto start = std::chrono::steady_clock::now();
+
+        for (uint64_t frame = 0; frame < num_frames; frame++) {
+            if (movie) {
+                server.port1.set_buttons(movie->port1_inputs.at(frame));
+                server.port2.set_buttons(movie->port2_inputs.at(frame));
+            }
+
+            server.nes.run_frame();
+
+            if (frame == 0) {
+                double first_frame_us = 1e6 * std::chrono::duration<double>(std::chrono::steady_clock::now() - accepted).count();
+                write_line(client, "first_frame_us " + std::to_string(first_frame_us));
+            }
+        }
+
+        const Screen& screen = server.nes.ppu->screen;
+        uint64_t hash = hash_bytes(screen.pixels.data(), screen.pixels.size());
+
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        write_line(client, "done frames=" + std::to_string(num_frames) + " hash=" + hash_string(hash) + " seconds=" + std::to_string(seconds));
+    } catch (std::exception& e) {
+        write_line(client, string("error ") + e.what());
+    }
+}
+
+sockaddr_un make_address(const string& socket_path) {
+    sockaddr_un address;
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+
+    if (socket_path.size() >= sizeof(address.sun_path)) {
+        throw std::runtime_error("Socket path is too long: " + socket_path);
+    }
+
+    std::strcpy(address.sun_path, socket_path.c_str());
+
+    return address;
+}
+
+int run_server(const string& rom_file, const string& socket_path, uint64_t boot_frames) {
+    Server server;
+
+    auto start = std::chrono::steady_clock::now();
+
+    server.cartridge = std::make_unique<Cartridge>(rom_file);
+    server.nes.io->connect_controller(&server.port1, 1);
+    server.nes.io->connect_controller(&server.port2, 2);
+    server.nes.insert_cartridge(server.cartridge.get());
+    server.nes.reset();
+
+    for (uint64_t i = 0; i < boot_frames; i++) {
+        server.nes.run_frame();
+    }
+
+    double boot_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    sockaddr_un address = make_address(socket_path);
+    int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+
+    if (listener < 0) {
+        throw std::runtime_error("Failed to create socket");
+    }
+
+    unlink(socket_path.c_str());
+
+    if (bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0 || listen(listener, 64) < 0) {
+        throw std::runtime_error("Failed to listen on " + socket_path);
+    }
+
+    // Workers are never waited on, so let the kernel reap them
+    signal(SIGCHLD, SIG_IGN);
+
+    std::cout << "Booted " << rom_file << " to frame " << boot_frames << " in " << 1e6 * boot_seconds << " us, listening on " << socket_path << std::endl;
+
+    while (true) {
+        int client = accept(listener, nullptr, nullptr);
+
+        if (client < 0) {
+            continue;
+        }
+
+        auto accepted = std::chrono::steady_clock::now();
+
+        // Anything still buffered would be written twice otherwise
+        std::cout.flush();
+
+        pid_t pid = fork();
+
+        if (pid == 0) {
+            close(listener);
+            serve_request(server, client, accepted);
+            close(client);
+            _exit(0);
+        }
+
+        if (pid < 0) {
+            write_line(client, "error fork failed");
+        }
+
+        close(client);
+    }
+}
+
+int run_client(const string& socket_path, const string& request) {
+    sockaddr_un address = make_address(socket_path);
+    int server = socket(AF_UNIX, SOCK_STREAM, 0);
+
+    auto start = std::chrono::steady_clock::now();
+
+    if (server < 0 || connect(server, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0) {
+        throw std::runtime_error("Failed to connect to " + socket_path);
+    }
+
+    write_line(server, request);
+
+    string response;
+    bool first = true;
+    bool failed = false;
+
+    while (read_line(server, response)) {
+        if (first) {
+            double elapsed_us = 1e6 * std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            std::cout << "client_first_response_us " << elapsed_us << std::endl;
+            first = false;
+        }
+
+        std::cout << response << std::endl;
+        failed |= response.rfind("error", 0) == 0;
+    }
+
+    close(server);
+
+    return failed ? 1 : 0;
+}
+
+void print_usage() {
+    std::cout << "Usage:" << std::endl;
+    std::cout << "  ./nesforkserver serve <rom name in roms/> <socket path> [--frames N]" << std::endl;
+    std::cout << "  ./nesforkserver request <socket path> <frames> [movie.fm2]" << std::endl;
+}
+
+int main(int argc, char** argv) {
+
+    if (argc < 4) {
+        print_usage();
+        return 1;
+    }
+
+    string mode = argv[1];
+
+    try {
+        if (mode == "serve") {
+            uint64_t boot_frames = 0;
+
+            if (argc >= 6 && string(argv[4]) == "--frames") {
+                boot_frames = std::stoull(argv[5]);
+            }
+
+            return run_server(argv[2], argv[3], boot_frames);
+        } else if (mode == "request") {
+            string request = argv[3];
+
+            if (argc >= 5) {
+                request += " " + string(argv[4]);
+            }
+
+            return run_client(argv[2], request);
+        }
+    } catch (std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    print_usage();
+    return 1;
+}
@@ -0,0 +1,203 @@
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "Bus.h"
+#include "Movie.h"
+#include "controllers/VirtualController.h"
+
+using std::string;
+using std::vector;
+
+// Runs a ROM headlessly and prints a framebuffer hash and a machine state hash for every frame, for regression tests
+// and for finding the first frame two runs (two builds, two render paths, two netplay peers) disagree on
+void print_usage() {
+    std::cout << "Usage: ./neshash <rom name in roms/> [--frames N] [--movie file.fm2] [--state-only [--frame-skip N]] [--compare reference.txt]" << std::endl;
+    std::cout << "Prints one line per frame: <frame> <frame hash> <state hash>. Runs N frames (600 by default), or the length of the movie." << std::endl;
+    std::cout << "--state-only skips the frame hashes, printing - instead. Skipped frames aren't drawn, so --frame-skip needs it." << std::endl;
+    std::cout << "--compare checks the run against an earlier run's output and reports the first frame they disagree on." << std::endl;
+}
+
+struct Options {
+    string rom_file;
+    uint64_t frames = 600;
+    std::unique_ptr<Movie> movie;
+    uint32_t frame_skip = 0;
+    bool state_only = false;
+    string reference_file;
+};
+
+struct FrameHashes {
+    uint64_t frame;
+
+    // False with --state-only, or for a reference line with - in place of the frame hash
+    bool is_frame_hashed;
+    uint64_t frame_hash;
+    uint64_t state_hash;
+};
+
+string hash_string(uint64_t hash) {
+    char buffer[17];
+    std::snprintf(buffer, sizeof(buffer), "%016llx", static_cast<unsigned long long>(hash));
+    return buffer;
+}
+
+string format_line(const FrameHashes& hashes) {
+    return std::to_string(hashes.frame) + " " + (hashes.is_frame_hashed ? hash_string(hashes.frame_hash) : "-") + " " + hash_string(hashes.state_hash);
+}
+
+vector<FrameHashes> load_reference(const string& file_name) {
+    std::ifstream file(file_name);
+
+    if (!file.is_open()) {
+        throw std::runtime_error("Failed to open reference file " + file_name);
+    }
+
+    vector<FrameHashes> reference;
+    string line;
+
+    while (std::getline(file, line)) {
+        std::stringstream line_stream(line);
+        FrameHashes hashes;
+        string frame_hash;
+        string state_hash;
+
+        if (!(line_stream >> hashes.frame >> frame_hash >> state_hash)) {
+            continue;
+        }
+
+        hashes.is_frame_hashed = frame_hash != "-";
+        hashes.frame_hash = hashes.is_frame_hashed ? std::stoull(frame_hash, nullptr, 16) : 0;
+        hashes.state_hash = std::stoull(state_hash, nullptr, 16);
+        reference.push_back(hashes);
+    }
+
+    return reference;
+}
+
+// Where the run first disagrees with the reference, or an empty string if it never does.
+// A frame which either run didn't hash the picture of can only be compared by its state
+string find_mismatch(const vector<FrameHashes>& run, const vector<FrameHashes>& reference) {
+    if (run.size() != reference.size()) {
+        return "frame counts differ: " + std::to_string(run.size()) + " in this run, " + std::to_string(reference.size()) + " in the reference";
+    }
+
+    for (size_t i = 0; i < run.size(); i++) {
+        if (run[i].state_hash != reference[i].state_hash) {
+            return "state differs at frame " + std::to_string(run[i].frame);
+        }
+
+        if (run[i].is_frame_hashed && reference[i].is_frame_hashed && run[i].frame_hash != reference[i].frame_hash) {
+            return "picture differs at frame " + std::to_string(run[i].frame);
+        }
+    }
+
+    return "";
+}
+
+vector<FrameHashes> run_rom(const Options& options) {
+    Bus nes;
+    std::unique_ptr<Cartridge> game = std::make_unique<Cartridge>(options.rom_file);
+    VirtualController port1;
+    VirtualController port2;
+
+    nes.io->connect_controller(&port1, 1);
+    nes.io->connect_controller(&port2, 2);
+    nes.ppu->set_frame_skip(options.frame_skip);
+    nes.insert_cartridge(game.get());
+    nes.reset();
+
+    vector<FrameHashes> run;
+    run.reserve(options.frames);
+
+    for (uint64_t frame = 0; frame < options.frames; frame++) {
+        if (options.movie) {
+            port1.set_buttons(options.movie->port1_inputs.at(frame));
+            port2.set_buttons(options.movie->port2_inputs.at(frame));
+        }
+
+        nes.run_frame();
+
+        run.push_back({frame, !options.state_only, options.state_only ? 0 : nes.hash_frame(), nes.hash_state()});
+    }
+
+    return run;
+}
+
+int main(int argc, char** argv) {
+
+    if (argc < 2) {
+        print_usage();
+        return 1;
+    }
+
+    Options options;
+    options.rom_file = argv[1];
+
+    try {
+        for (int i = 2; i < argc; i++) {
+            string arg = argv[i];
+
+            if (arg == "--frames" && i + 1 < argc) {
+                options.frames = std::stoull(argv[++i]);
+            } else if (arg == "--movie" && i + 1 < argc) {
+                options.movie = std::make_unique<Movie>(argv[++i]);
+                options.frames = options.movie->num_frames();
+            } else if (arg == "--frame-skip" && i + 1 < argc) {
+                options.frame_skip = std::stoul(argv[++i]);
+            } else if (arg == "--state-only") {
+                options.state_only = true;
+            } else if (arg == "--compare" && i + 1 < argc) {
+                options.reference_file = argv[++i];
+            } else {
+                print_usage();
+                return 1;
+            }
+        }
+
+        // The screen isn't redrawn on skipped frames, so their frame hashes would just repeat the last drawn one
+        if (options.frame_skip > 0 && !options.state_only) {
+            throw std::runtime_error("--frame-skip can't be combined with frame hashes, add --state-only");
+        }
+
+        vector<FrameHashes> reference;
+
+        if (!options.reference_file.empty()) {
+            reference = load_reference(options.reference_file);
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        vector<FrameHashes> run = run_rom(options);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        // Printed after the run, so writing to the terminal doesn't count towards the time
+        for (const FrameHashes& hashes : run) {
+            std::cout << format_line(hashes) << "\n";
+        }
+
+        std::cout.flush();
+        std::cerr << "time: " << seconds << " s, " << (seconds > 0 ? run.size() / seconds : 0) << " frames per second" << std::endl;
+
+        if (!options.reference_file.empty()) {
+            string mismatch = find_mismatch(run, reference);
+
+            if (!mismatch.empty()) {
+                std::cerr << "MISMATCH: " << mismatch << std::endl;
+                return 2;
+            }
+
+            std::cerr << "matches " << options.reference_file << std::endl;
+        }
+    } catch (std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
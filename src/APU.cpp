@@ -1,30 +1,328 @@
 
 #include "APU.h"
+#include "APUWorker.h"
 
+#include <algorithm>
+#include <cstdint>
 #include <stdexcept>
 #include <string>
 
-APU::APU() {
+namespace {
+
+// Length counter values, indexed by the top 5 bits of 4003/4007/400B/400F
+const uint8_t LENGTH_TABLE[32] = {
+    10, 254, 20,  2, 40,  4, 80,  6, 160,  8, 60, 10, 14, 12, 26, 14,
+    12,  16, 24, 18, 48, 20, 96, 22, 192, 24, 72, 26, 16, 28, 32, 30
+};
+
+// Pulse waveforms for each duty setting: 12.5%, 25%, 50% and 25% negated
+const uint8_t DUTY_TABLE[4][8] = {
+    {0, 1, 0, 0, 0, 0, 0, 0},
+    {0, 1, 1, 0, 0, 0, 0, 0},
+    {0, 1, 1, 1, 1, 0, 0, 0},
+    {1, 0, 0, 1, 1, 1, 1, 1}
+};
+
+const uint8_t TRIANGLE_SEQUENCE[32] = {
+    15, 14, 13, 12, 11, 10,  9,  8,  7,  6,  5,  4,  3,  2,  1,  0,
+     0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14, 15
+};
+
+// Timer periods in CPU cycles (NTSC)
+const uint16_t NOISE_PERIODS[16] = {4, 8, 16, 32, 64, 96, 128, 160, 202, 254, 380, 508, 762, 1016, 2034, 4068};
+const uint16_t DMC_PERIODS[16] = {428, 380, 340, 320, 286, 254, 226, 214, 190, 160, 142, 128, 106, 84, 72, 54};
+
+// CPU cycles into the sequence at which the frame counter steps, for the 4-step and 5-step modes,
+// and the length of the whole sequence
+const uint32_t FRAME_STEP_CYCLES[2][4] = {{7457, 14913, 22371, 29829}, {7457, 14913, 22371, 37281}};
+const uint32_t FRAME_SEQUENCE_CYCLES[2] = {29830, 37282};
+
+// The noise shift register repeats itself after this many shifts, from any starting value,
+// in normal and loop mode (where the sequence is 93 or 31 shifts long)
+const uint32_t NOISE_SEQUENCE_LENGTHS[2] = {32767, 93};
+
+// Count a timer down by the given number of CPU cycles, reloading it with period each time it expires.
+// Returns how many times it expired
+uint32_t count_down(uint32_t& counter, uint32_t period, uint32_t cycles) {
+    if (cycles < counter) {
+        counter -= cycles;
+        return 0;
+    }
+
+    uint32_t cycles_past_expiry = cycles - counter;
+    counter = period - cycles_past_expiry % period;
+
+    return 1 + cycles_past_expiry / period;
+}
+
+// The nonlinear mixer as lookup tables of 16-bit amplitudes. The pulse channels are mixed exactly, indexed by the sum
+// of their outputs. The triangle, noise and DMC are indexed by 3 * triangle + 2 * noise + DMC, the usual linear
+// approximation of their weights, which stays within about 1% of full scale of the exact formula
+struct MixerTables {
+    static const int NUM_PULSE_LEVELS = 31;
+    static const int NUM_TND_LEVELS = 203;
+
+    int16_t pulse[NUM_PULSE_LEVELS];
+    int16_t tnd[NUM_TND_LEVELS];
+
+    MixerTables() {
+        pulse[0] = 0;
+        tnd[0] = 0;
+
+        for (int i = 1; i < NUM_PULSE_LEVELS; i++) {
+            pulse[i] = static_cast<int16_t>(95.88 / (8128.0 / i + 100.0) * APU::OUTPUT_SCALE);
+        }
+
+        for (int i = 1; i < NUM_TND_LEVELS; i++) {
+            tnd[i] = static_cast<int16_t>(163.67 / (24329.0 / i + 100.0) * APU::OUTPUT_SCALE);
+        }
+    }
+};
+
+const MixerTables& mixer_tables() {
+    static const MixerTables tables;
+    return tables;
+}
+
+}
+
+void Envelope::clock(uint8_t period, bool loop) {
+    if (start) {
+        start = false;
+        decay_level = 15;
+        divider = period;
+        return;
+    }
+
+    if (divider > 0) {
+        divider--;
+        return;
+    }
+
+    divider = period;
+
+    if (decay_level > 0) {
+        decay_level--;
+    } else if (loop) {
+        decay_level = 15;
+    }
+}
+
+void Pulse_Channel::run_timer(uint32_t cycles) {
+    uint32_t steps = count_down(timer_counter, period(), cycles);
+    duty_step = (duty_step + steps) & 0x7;
+}
+
+void Pulse_Channel::clock_length_counter() {
+    if (!length_counter_halted && length_counter > 0) {
+        length_counter--;
+    }
+}
+
+uint16_t Pulse_Channel::sweep_target() const {
+    uint16_t change = timer >> sweep_shift;
+
+    if (!is_sweep_negated) {
+        return timer + change;
+    }
+
+    // Pulse 1 subtracts one more
+    uint16_t subtracted = change + (is_pulse_1 ? 1 : 0);
+    return subtracted > timer ? 0 : timer - subtracted;
+}
+
+void Pulse_Channel::clock_sweep() {
+    uint16_t target = sweep_target();
+
+    if (sweep_divider == 0 && sweep_enabled && sweep_shift > 0 && timer >= 8 && target <= 0x7FF) {
+        timer = target;
+    }
+
+    if (sweep_divider == 0 || sweep_reload) {
+        sweep_divider = sweep_period;
+        sweep_reload = false;
+    } else {
+        sweep_divider--;
+    }
+}
+
+uint8_t Pulse_Channel::output() const {
+    // Periods below 8, or a sweep target past 0x7FF, mute the channel
+    if (length_counter == 0 || !DUTY_TABLE[duty][duty_step] || timer < 8 || sweep_target() > 0x7FF) {
+        return 0;
+    }
+
+    return is_volume_constant ? volume : envelope.decay_level;
+}
+
+bool Pulse_Channel::is_audible() const {
+    return length_counter > 0 && timer >= 8 && sweep_target() <= 0x7FF && (is_volume_constant ? volume : envelope.decay_level) > 0;
+}
+
+void Triangle_Channel::run_timer(uint32_t cycles) {
+    uint32_t steps = count_down(timer_counter, period(), cycles);
+
+    if (is_stepping()) {
+        sequence_step = (sequence_step + steps) & 0x1F;
+    }
+}
+
+bool Triangle_Channel::is_stepping() const {
+    // Periods below 2 are ultrasonic. Real hardware still steps, but that only adds a pop, so hold the output instead
+    return length_counter > 0 && linear_counter > 0 && timer >= 2;
+}
+
+void Triangle_Channel::clock_length_counter() {
+    if (!length_counter_halted && length_counter > 0) {
+        length_counter--;
+    }
+}
+
+void Triangle_Channel::clock_linear_counter() {
+    if (linear_counter_reload_flag) {
+        linear_counter = linear_counter_reload;
+    } else if (linear_counter > 0) {
+        linear_counter--;
+    }
+
+    // The control flag doubles as the length counter halt flag
+    if (!length_counter_halted) {
+        linear_counter_reload_flag = false;
+    }
+}
 
+uint8_t Triangle_Channel::output() const {
+    return TRIANGLE_SEQUENCE[sequence_step];
+}
+
+uint32_t Noise_Channel::period() const {
+    return NOISE_PERIODS[noise_period];
+}
+
+void Noise_Channel::run_timer(uint32_t cycles) {
+    uint32_t steps = count_down(timer_counter, period(), cycles) % NOISE_SEQUENCE_LENGTHS[loop_noise];
+
+    // Loop mode taps bit 6 instead of bit 1, which gives a short, metallic sequence
+    int tap = loop_noise ? 6 : 1;
+
+    for (uint32_t i = 0; i < steps; i++) {
+        uint16_t feedback = (shift_register ^ (shift_register >> tap)) & 0x1;
+        shift_register = (shift_register >> 1) | (feedback << 14);
+    }
+}
+
+void Noise_Channel::clock_length_counter() {
+    if (!length_counter_halted && length_counter > 0) {
+        length_counter--;
+    }
+}
+
+uint8_t Noise_Channel::output() const {
+    if (length_counter == 0 || (shift_register & 0x1)) {
+        return 0;
+    }
+
+    return is_volume_constant ? volume : envelope.decay_level;
+}
+
+bool Noise_Channel::is_audible() const {
+    return length_counter > 0 && (is_volume_constant ? volume : envelope.decay_level) > 0;
+}
+
+uint32_t DMC_Channel::period() const {
+    return DMC_PERIODS[frequency];
+}
+
+void DMC_Channel::restart_sample() {
+    current_address = 0xC000 + sample_address * 64;
+    bytes_remaining = sample_length * 16 + 1;
+}
+
+void DMC_Channel::clock_output_unit() {
+    // Move the level up or down by 2 for each bit of the sample
+    if (!is_silent) {
+        if (shift_register & 0x1) {
+            if (output_level <= 125) {
+                output_level += 2;
+            }
+        } else if (output_level >= 2) {
+            output_level -= 2;
+        }
+    }
+
+    shift_register >>= 1;
+    bits_remaining--;
+
+    if (bits_remaining == 0) {
+        bits_remaining = 8;
+
+        if (is_sample_buffer_empty) {
+            is_silent = true;
+        } else {
+            is_silent = false;
+            shift_register = sample_buffer;
+            is_sample_buffer_empty = true;
+        }
+    }
+}
+
+bool DMC_Channel::is_idle() const {
+    return is_silent && is_sample_buffer_empty && bytes_remaining == 0;
+}
+
+uint32_t Frame_Counter::cycles_to_next_step() const {
+    for (uint32_t step_cycle : FRAME_STEP_CYCLES[mode]) {
+        if (step_cycle > cycles_elapsed) {
+            return step_cycle - cycles_elapsed;
+        }
+    }
+
+    return FRAME_SEQUENCE_CYCLES[mode] - cycles_elapsed;
+}
+
+APU::APU() {
+    pulse_channel_1.is_pulse_1 = true;
 }
 
 uint8_t APU::read_from_cpu(uint16_t address) {
     switch (address) {
         case 0x4015:
             {
-                bool status = !this->frame_counter.irq_inhibited << 6;
-                this->frame_counter.irq_inhibited = 1;
-                this->bus->cpu->reset_IRQ();
+                catch_up();
+
+                uint8_t status =
+                    (dmc_channel.irq_flag << 7) |
+                    (frame_counter.irq_triggered << 6) |
+                    ((dmc_channel.bytes_remaining > 0) << 4) |
+                    ((noise_channel.length_counter > 0) << 3) |
+                    ((triangle_channel.length_counter > 0) << 2) |
+                    ((pulse_channel_2.length_counter > 0) << 1) |
+                    (pulse_channel_1.length_counter > 0);
+
+                // Reading the status acknowledges the frame interrupt, but not the DMC one
+                frame_counter.irq_triggered = false;
+                lower_cpu_irq(IRQ_APU_FRAME);
+
                 return status;
             }
         default:
-            // This should throw an error, but since APU isn't fully implemented yet I want programs to still be able to run
-            //throw std::runtime_error("Attempted to read APU from invalid address " + std::to_string(address));
+            // The other APU registers are write only
             return 0;
     }
 }
 
 void APU::write_from_cpu(uint16_t address, uint8_t val) {
+    // Changes take effect from the current cycle, so run the channels up to it first
+    catch_up();
+
+    if (worker != nullptr) {
+        worker->log_write(cycle, address, val);
+    }
+
+    write_register(address, val);
+}
+
+void APU::write_register(uint16_t address, uint8_t val) {
     switch (address) {
         case 0x4000:
             pulse_channel_1.duty = (val & 0xCF) >> 6;
@@ -34,16 +332,24 @@ void APU::write_from_cpu(uint16_t address, uint8_t val) {
             break;
         case 0x4001:
             pulse_channel_1.sweep_enabled = val & 0x80;
-            pulse_channel_1.sweep_period = val & 0x70;
+            pulse_channel_1.sweep_period = (val & 0x70) >> 4;
             pulse_channel_1.is_sweep_negated = val & 0x08;
             pulse_channel_1.sweep_shift = val & 0x07;
+            pulse_channel_1.sweep_reload = true;
             break;
         case 0x4002:
             pulse_channel_1.timer = (pulse_channel_1.timer & 0x700) | val;
             break;
         case 0x4003:
-            pulse_channel_1.sound_length = val >> 5;
+            pulse_channel_1.sound_length = val >> 3;
             pulse_channel_1.timer = (pulse_channel_1.timer & 0x0FF) | ((val & 0x7) << 8);
+
+            if (apu_status.pulse_1_enable) {
+                pulse_channel_1.length_counter = LENGTH_TABLE[pulse_channel_1.sound_length];
+            }
+
+            pulse_channel_1.duty_step = 0;
+            pulse_channel_1.envelope.start = true;
             break;
         case 0x4004:
             pulse_channel_2.duty = (val & 0xCF) >> 6;
@@ -53,40 +359,85 @@ void APU::write_from_cpu(uint16_t address, uint8_t val) {
             break;
         case 0x4005:
             pulse_channel_2.sweep_enabled = val & 0x80;
-            pulse_channel_2.sweep_period = val & 0x70;
+            pulse_channel_2.sweep_period = (val & 0x70) >> 4;
             pulse_channel_2.is_sweep_negated = val & 0x08;
             pulse_channel_2.sweep_shift = val & 0x07;
+            pulse_channel_2.sweep_reload = true;
             break;
         case 0x4006:
             pulse_channel_2.timer = (pulse_channel_2.timer & 0x700) | val;
             break;
         case 0x4007:
-            pulse_channel_1.sound_length = val >> 5;
-            pulse_channel_1.timer = (pulse_channel_1.timer & 0x0FF) | ((val & 0x7) << 8);
+            pulse_channel_2.sound_length = val >> 3;
+            pulse_channel_2.timer = (pulse_channel_2.timer & 0x0FF) | ((val & 0x7) << 8);
+
+            if (apu_status.pulse_2_enable) {
+                pulse_channel_2.length_counter = LENGTH_TABLE[pulse_channel_2.sound_length];
+            }
+
+            pulse_channel_2.duty_step = 0;
+            pulse_channel_2.envelope.start = true;
             break;
         case 0x4008:
+            triangle_channel.length_counter_halted = val & 0x80;
+            triangle_channel.linear_counter_reload = val & 0x7F;
             break;
         case 0x4009:
+            // Unused
             break;
         case 0x400A:
+            triangle_channel.timer = (triangle_channel.timer & 0x700) | val;
             break;
         case 0x400B:
+            triangle_channel.sound_length = val >> 3;
+            triangle_channel.timer = (triangle_channel.timer & 0x0FF) | ((val & 0x7) << 8);
+
+            if (apu_status.triangle_enable) {
+                triangle_channel.length_counter = LENGTH_TABLE[triangle_channel.sound_length];
+            }
+
+            triangle_channel.linear_counter_reload_flag = true;
             break;
         case 0x400C:
+            noise_channel.length_counter_halted = val & 0x20;
+            noise_channel.is_volume_constant = val & 0x10;
+            noise_channel.volume = val & 0x0F;
             break;
         case 0x400D:
+            // Unused
             break;
         case 0x400E:
+            noise_channel.loop_noise = val & 0x80;
+            noise_channel.noise_period = val & 0x0F;
             break;
         case 0x400F:
+            noise_channel.sound_length = val >> 3;
+
+            if (apu_status.noise_enable) {
+                noise_channel.length_counter = LENGTH_TABLE[noise_channel.sound_length];
+            }
+
+            noise_channel.envelope.start = true;
             break;
         case 0x4010:
+            dmc_channel.irq_enable = val & 0x80;
+            dmc_channel.is_looping = val & 0x40;
+            dmc_channel.frequency = val & 0x0F;
+
+            if (!dmc_channel.irq_enable) {
+                dmc_channel.irq_flag = false;
+                lower_cpu_irq(IRQ_DMC);
+            }
             break;
         case 0x4011:
+            dmc_channel.load_counter = val & 0x7F;
+            dmc_channel.output_level = dmc_channel.load_counter;
             break;
         case 0x4012:
+            dmc_channel.sample_address = val;
             break;
         case 0x4013:
+            dmc_channel.sample_length = val;
             break;
         case 0x4015:
             apu_status.dmc_enable = val & 0x10;
@@ -94,67 +445,516 @@ void APU::write_from_cpu(uint16_t address, uint8_t val) {
             apu_status.triangle_enable = val & 0x04;
             apu_status.pulse_2_enable = val & 0x02;
             apu_status.pulse_1_enable = val & 0x01;
+
+            // Disabling a channel silences it straight away
+            if (!apu_status.pulse_1_enable) {
+                pulse_channel_1.length_counter = 0;
+            }
+
+            if (!apu_status.pulse_2_enable) {
+                pulse_channel_2.length_counter = 0;
+            }
+
+            if (!apu_status.triangle_enable) {
+                triangle_channel.length_counter = 0;
+            }
+
+            if (!apu_status.noise_enable) {
+                noise_channel.length_counter = 0;
+            }
+
+            if (!apu_status.dmc_enable) {
+                dmc_channel.bytes_remaining = 0;
+            } else if (dmc_channel.bytes_remaining == 0) {
+                dmc_channel.restart_sample();
+
+                // With the buffer empty, the memory reader fetches the first byte straight away
+                if (dmc_channel.is_sample_buffer_empty) {
+                    fetch_dmc_sample();
+                }
+            }
+
+            // Writing the status acknowledges the DMC interrupt
+            dmc_channel.irq_flag = false;
+            lower_cpu_irq(IRQ_DMC);
             break;
         case 0x4017:
             frame_counter.mode = val & 0x80;
             frame_counter.irq_inhibited = val & 0x40;
 
             if (frame_counter.irq_inhibited) {
-                this->bus->cpu->reset_IRQ();
+                frame_counter.irq_triggered = false;
+                lower_cpu_irq(IRQ_APU_FRAME);
+            }
+
+            // The sequence restarts, and the 5-step mode clocks everything straight away
+            frame_counter.cycles_elapsed = 0;
+
+            if (frame_counter.mode) {
+                clock_quarter_frame();
+                clock_half_frame();
             }
             break;
         default:
             throw std::runtime_error("Attempted to write to APU from invalid address " + std::to_string(address));
             break;
     }
+
+    update_output();
+    schedule_next_event();
 }
 
 void APU::attach_bus(Bus* b) {
     bus = b;
 }
 
-void APU::tick() {
+void APU::attach_worker(APUWorker* new_worker) {
+    // Play out what the old worker was given so far
+    if (worker != nullptr) {
+        worker->end_frame(cycle);
+        worker->wait_until_idle();
+    }
 
-    // The frame counter keeps track of how many APU cycles have passed
-    // Based on its mode, it will periodically clock each of the sound generators
+    worker = new_worker;
+    log_start_cycle = cycle;
 
-    // These values for cycles_elapsed are for NTSC machines only!!!
+    if (worker != nullptr) {
+        worker->start(*this);
+    }
 
-    if (frame_counter.mode == 0) {
-        if (frame_counter.cycles_elapsed == 3728) {
+    next_event_cycle = cycle;
+}
 
-        } else if (frame_counter.cycles_elapsed == 7456) {
-    
-        } else if (frame_counter.cycles_elapsed == 11185) {
-    
-        } else if (frame_counter.cycles_elapsed == 14914) {
+void APU::raise_cpu_irq(irq_source source) {
+    if (bus != nullptr) {
+        bus->cpu->assert_IRQ(source);
+    }
+}
 
-        } else if (frame_counter.cycles_elapsed == 14915) {
-            if (!frame_counter.irq_inhibited) {
-                this->bus->cpu->trigger_IRQ();
-            }
-        } else if (frame_counter.cycles_elapsed == 14916) {
-            // Counter resets to 0 on the next APU cycle
-            // Set to -1 because this variable will be incremented at the end of the function
-            frame_counter.cycles_elapsed = -1;
+void APU::lower_cpu_irq(irq_source source) {
+    if (bus != nullptr) {
+        bus->cpu->release_IRQ(source);
+    }
+}
+
+void APU::attach_audio_output(AudioOutput* output) {
+    audio_output = output;
+    block_start_cycle = cycle;
+
+    if (audio_output != nullptr) {
+        blip_buffer.set_rates(CPU_CLOCK_RATE, audio_output->requested_sample_rate());
+
+        // Start from the current level, so the output doesn't depend on when the next event happens to be
+        update_output();
+    }
+
+    // Channel edges only count as events while there is an output, so the schedule changes
+    next_event_cycle = cycle;
+}
+
+void APU::clock_quarter_frame() {
+    pulse_channel_1.envelope.clock(pulse_channel_1.volume, pulse_channel_1.length_counter_halted);
+    pulse_channel_2.envelope.clock(pulse_channel_2.volume, pulse_channel_2.length_counter_halted);
+    noise_channel.envelope.clock(noise_channel.volume, noise_channel.length_counter_halted);
+    triangle_channel.clock_linear_counter();
+}
+
+void APU::clock_half_frame() {
+    pulse_channel_1.clock_length_counter();
+    pulse_channel_1.clock_sweep();
+    pulse_channel_2.clock_length_counter();
+    pulse_channel_2.clock_sweep();
+    triangle_channel.clock_length_counter();
+    noise_channel.clock_length_counter();
+}
+
+void APU::fetch_dmc_sample() {
+    if (dmc_source != nullptr) {
+        dmc_channel.sample_buffer = dmc_source->next_dmc_byte();
+    } else {
+        dmc_channel.sample_buffer = bus->read_cpu(dmc_channel.current_address);
+
+        // The fetch takes the bus away from the CPU, the same way OAM DMA does
+        bus->stall_cpu(DMC_FETCH_STALL_CYCLES);
+
+        if (worker != nullptr) {
+            worker->log_dmc_byte(dmc_channel.sample_buffer);
         }
+    }
+
+    dmc_channel.is_sample_buffer_empty = false;
+
+    dmc_channel.current_address = dmc_channel.current_address == 0xFFFF ? 0x8000 : dmc_channel.current_address + 1;
+    dmc_channel.bytes_remaining--;
+
+    if (dmc_channel.bytes_remaining == 0) {
+        if (dmc_channel.is_looping) {
+            dmc_channel.restart_sample();
+        } else if (dmc_channel.irq_enable) {
+            dmc_channel.irq_flag = true;
+            raise_cpu_irq(IRQ_DMC);
+        }
+    }
+}
+
+void APU::run_dmc_timer(uint32_t cycles) {
+    uint32_t steps = count_down(dmc_channel.timer_counter, dmc_channel.period(), cycles);
+
+    if (dmc_channel.is_idle()) {
+        // Only the bit counter moves, so skip straight to where it ends up
+        uint32_t bits_done = (8 - dmc_channel.bits_remaining + steps) % 8;
+        dmc_channel.bits_remaining = 8 - bits_done;
+        return;
+    }
+
+    // Not idle, so the DMC timer is an event and expires at most once
+    for (uint32_t i = 0; i < steps; i++) {
+        dmc_channel.clock_output_unit();
+    }
+}
+
+int APU::mix() const {
+    return mix_levels(pulse_channel_1.output(), pulse_channel_2.output(), triangle_channel.output(), noise_channel.output(), dmc_channel.output_level);
+}
+
+int APU::mix_levels(uint8_t pulse_1, uint8_t pulse_2, uint8_t triangle, uint8_t noise, uint8_t dmc) {
+    const MixerTables& tables = mixer_tables();
+    return tables.pulse[pulse_1 + pulse_2] + tables.tnd[3 * triangle + 2 * noise + dmc];
+}
+
+void APU::update_output() {
+    if (audio_output == nullptr) {
+        return;
+    }
+
+    int amplitude = mix();
+
+    if (amplitude != last_amplitude) {
+        blip_buffer.add_delta(cycle - block_start_cycle, amplitude - last_amplitude);
+        last_amplitude = amplitude;
+    }
+}
+
+void APU::end_block() {
+    blip_buffer.end_block(cycle - block_start_cycle);
+    block_start_cycle = cycle;
+
+    size_t num_samples = blip_buffer.read_samples(sample_block.data(), sample_block.size());
+
+    if (num_samples > 0) {
+        audio_output->write_samples(sample_block.data(), num_samples);
+    }
+
+    // Applies from the next block on
+    blip_buffer.set_rates(CPU_CLOCK_RATE, audio_output->requested_sample_rate());
+}
+
+void APU::clock_frame_counter() {
+    const uint32_t* step_cycles = FRAME_STEP_CYCLES[frame_counter.mode];
+    uint32_t elapsed = frame_counter.cycles_elapsed;
+
+    // These cycle counts are for NTSC machines only!!!
+    if (elapsed == step_cycles[0] || elapsed == step_cycles[2]) {
+        clock_quarter_frame();
+    } else if (elapsed == step_cycles[1]) {
+        clock_quarter_frame();
+        clock_half_frame();
+    } else if (elapsed == step_cycles[3]) {
+        clock_quarter_frame();
+        clock_half_frame();
+
+        // Only the 4-step sequence raises an IRQ
+        if (frame_counter.mode == 0 && !frame_counter.irq_inhibited) {
+            frame_counter.irq_triggered = true;
+            raise_cpu_irq(IRQ_APU_FRAME);
+        }
+    } else if (elapsed == FRAME_SEQUENCE_CYCLES[frame_counter.mode]) {
+        frame_counter.cycles_elapsed = 0;
+    }
+}
+
+uint32_t APU::cycles_to_next_event() const {
+    uint32_t cycles = frame_counter.cycles_to_next_step();
+
+    // The DMC's fetches stall the CPU and can raise an IRQ, so it is followed whether or not anyone is listening
+    if (!dmc_channel.is_idle()) {
+        cycles = std::min(cycles, dmc_channel.timer_counter);
+    }
+
+    if (worker != nullptr) {
+        cycles = std::min(cycles, static_cast<uint32_t>(log_start_cycle + APUWorker::FRAME_CYCLES - cycle));
+    }
+
+    if (audio_output == nullptr) {
+        return cycles;
+    }
+
+    cycles = std::min(cycles, static_cast<uint32_t>(block_start_cycle + BLOCK_CYCLES - cycle));
+
+    // Timers of silent channels still run, but they don't change the output, so they don't need their own events
+    if (pulse_channel_1.is_audible()) {
+        cycles = std::min(cycles, pulse_channel_1.timer_counter);
+    }
+
+    if (pulse_channel_2.is_audible()) {
+        cycles = std::min(cycles, pulse_channel_2.timer_counter);
+    }
+
+    if (triangle_channel.is_stepping()) {
+        cycles = std::min(cycles, triangle_channel.timer_counter);
+    }
+
+    if (noise_channel.is_audible()) {
+        cycles = std::min(cycles, noise_channel.timer_counter);
+    }
+
+    return cycles;
+}
+
+void APU::schedule_next_event() {
+    if (scheduling == APU_DISABLED) {
+        next_event_cycle = UINT64_MAX;
+    } else if (scheduling == APU_EVERY_CYCLE) {
+        next_event_cycle = cycle + 1;
     } else {
-        if (frame_counter.cycles_elapsed == 3728) {
-
-        } else if (frame_counter.cycles_elapsed == 7456) {
-    
-        } else if (frame_counter.cycles_elapsed == 11185) {
-    
-        } else if (frame_counter.cycles_elapsed == 14914) {
-    
-        } else if (frame_counter.cycles_elapsed == 18640) {
-
-        } else if (frame_counter.cycles_elapsed == 18641) {
-            // Counter resets to 0 on the next APU cycle
-            // Set to -1 because this variable will be incremented at the end of the function
-            frame_counter.cycles_elapsed = -1;
+        next_event_cycle = cycle + cycles_to_next_event();
+    }
+}
+
+void APU::run_until(uint64_t target_cycle) {
+    if (scheduling == APU_DISABLED) {
+        next_event_cycle = UINT64_MAX;
+        return;
+    }
+
+    while (true) {
+        // The memory reader refills the sample buffer as soon as it empties
+        if (dmc_channel.is_sample_buffer_empty && dmc_channel.bytes_remaining > 0) {
+            fetch_dmc_sample();
+        }
+
+        // After the fetch, so a byte fetched on the last cycle of a frame goes with the frame the worker replays it in
+        if (worker != nullptr && cycle - log_start_cycle >= APUWorker::FRAME_CYCLES) {
+            worker->end_frame(cycle);
+            log_start_cycle = cycle;
+        }
+
+        if (cycle >= target_cycle) {
+            break;
+        }
+
+        // Nothing observable happens before the next event, so every timer can jump straight there
+        uint32_t cycles = static_cast<uint32_t>(std::min<uint64_t>(target_cycle - cycle, cycles_to_next_event()));
+
+        pulse_channel_1.run_timer(cycles);
+        pulse_channel_2.run_timer(cycles);
+        triangle_channel.run_timer(cycles);
+        noise_channel.run_timer(cycles);
+        run_dmc_timer(cycles);
+
+        cycle += cycles;
+        frame_counter.cycles_elapsed += cycles;
+        clock_frame_counter();
+
+        if (audio_output != nullptr) {
+            update_output();
+
+            if (cycle - block_start_cycle >= BLOCK_CYCLES) {
+                end_block();
+            }
         }
     }
 
-    frame_counter.cycles_elapsed++;
-}
\ No newline at end of file
+    schedule_next_event();
+}
+
+void APU::catch_up() {
+    run_until(bus->num_cpu_cycles);
+}
+
+// The channels are written field by field, so struct padding never ends up in a state or its hash
+void Envelope::save_state(StateWriter& state) const {
+    state.write(start);
+    state.write(divider);
+    state.write(decay_level);
+}
+
+void Envelope::load_state(StateReader& state) {
+    state.read(start);
+    state.read(divider);
+    state.read(decay_level);
+}
+
+void Pulse_Channel::save_state(StateWriter& state) const {
+    state.write(duty);
+    state.write(length_counter_halted);
+    state.write(is_volume_constant);
+    state.write(volume);
+    state.write(sweep_enabled);
+    state.write(sweep_period);
+    state.write(is_sweep_negated);
+    state.write(sweep_shift);
+    state.write(timer);
+    state.write(sound_length);
+    state.write(is_pulse_1);
+    state.write(timer_counter);
+    state.write(duty_step);
+    state.write(length_counter);
+    envelope.save_state(state);
+    state.write(sweep_reload);
+    state.write(sweep_divider);
+}
+
+void Pulse_Channel::load_state(StateReader& state) {
+    state.read(duty);
+    state.read(length_counter_halted);
+    state.read(is_volume_constant);
+    state.read(volume);
+    state.read(sweep_enabled);
+    state.read(sweep_period);
+    state.read(is_sweep_negated);
+    state.read(sweep_shift);
+    state.read(timer);
+    state.read(sound_length);
+    state.read(is_pulse_1);
+    state.read(timer_counter);
+    state.read(duty_step);
+    state.read(length_counter);
+    envelope.load_state(state);
+    state.read(sweep_reload);
+    state.read(sweep_divider);
+}
+
+void Triangle_Channel::save_state(StateWriter& state) const {
+    state.write(length_counter_halted);
+    state.write(linear_counter_reload);
+    state.write(timer);
+    state.write(sound_length);
+    state.write(timer_counter);
+    state.write(sequence_step);
+    state.write(length_counter);
+    state.write(linear_counter);
+    state.write(linear_counter_reload_flag);
+}
+
+void Triangle_Channel::load_state(StateReader& state) {
+    state.read(length_counter_halted);
+    state.read(linear_counter_reload);
+    state.read(timer);
+    state.read(sound_length);
+    state.read(timer_counter);
+    state.read(sequence_step);
+    state.read(length_counter);
+    state.read(linear_counter);
+    state.read(linear_counter_reload_flag);
+}
+
+void Noise_Channel::save_state(StateWriter& state) const {
+    state.write(length_counter_halted);
+    state.write(is_volume_constant);
+    state.write(volume);
+    state.write(loop_noise);
+    state.write(noise_period);
+    state.write(sound_length);
+    state.write(timer_counter);
+    state.write(length_counter);
+    state.write(shift_register);
+    envelope.save_state(state);
+}
+
+void Noise_Channel::load_state(StateReader& state) {
+    state.read(length_counter_halted);
+    state.read(is_volume_constant);
+    state.read(volume);
+    state.read(loop_noise);
+    state.read(noise_period);
+    state.read(sound_length);
+    state.read(timer_counter);
+    state.read(length_counter);
+    state.read(shift_register);
+    envelope.load_state(state);
+}
+
+void DMC_Channel::save_state(StateWriter& state) const {
+    state.write(irq_enable);
+    state.write(is_looping);
+    state.write(frequency);
+    state.write(load_counter);
+    state.write(sample_address);
+    state.write(sample_length);
+    state.write(timer_counter);
+    state.write(output_level);
+    state.write(shift_register);
+    state.write(bits_remaining);
+    state.write(is_silent);
+    state.write(sample_buffer);
+    state.write(is_sample_buffer_empty);
+    state.write(current_address);
+    state.write(bytes_remaining);
+    state.write(irq_flag);
+}
+
+void DMC_Channel::load_state(StateReader& state) {
+    state.read(irq_enable);
+    state.read(is_looping);
+    state.read(frequency);
+    state.read(load_counter);
+    state.read(sample_address);
+    state.read(sample_length);
+    state.read(timer_counter);
+    state.read(output_level);
+    state.read(shift_register);
+    state.read(bits_remaining);
+    state.read(is_silent);
+    state.read(sample_buffer);
+    state.read(is_sample_buffer_empty);
+    state.read(current_address);
+    state.read(bytes_remaining);
+    state.read(irq_flag);
+}
+
+void Frame_Counter::save_state(StateWriter& state) const {
+    state.write(mode);
+    state.write(irq_inhibited);
+    state.write(irq_triggered);
+    state.write(cycles_elapsed);
+}
+
+void Frame_Counter::load_state(StateReader& state) {
+    state.read(mode);
+    state.read(irq_inhibited);
+    state.read(irq_triggered);
+    state.read(cycles_elapsed);
+}
+
+void APU::save_state(StateWriter& state) const {
+    pulse_channel_1.save_state(state);
+    pulse_channel_2.save_state(state);
+    triangle_channel.save_state(state);
+    noise_channel.save_state(state);
+    dmc_channel.save_state(state);
+    state.write(apu_status);
+    frame_counter.save_state(state);
+    state.write(cycle);
+}
+
+void APU::load_state(StateReader& state) {
+    pulse_channel_1.load_state(state);
+    pulse_channel_2.load_state(state);
+    triangle_channel.load_state(state);
+    noise_channel.load_state(state);
+    dmc_channel.load_state(state);
+    state.read(apu_status);
+    frame_counter.load_state(state);
+    state.read(cycle);
+
+    // Audio carries on from the restored cycle, and the next event is worked out when Bus::tick next runs
+    block_start_cycle = cycle;
+    next_event_cycle = cycle;
+
+    // The worker's copy starts over from the restored state
+    if (worker != nullptr) {
+        worker->start(*this);
+        log_start_cycle = cycle;
+    }
+}
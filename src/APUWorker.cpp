@@ -0,0 +1,109 @@
+#include "APUWorker.h"
+
+APUWorker::APUWorker(AudioOutput* output) : audio_output(output) {
+    thread = std::thread(&APUWorker::run, this);
+}
+
+APUWorker::~APUWorker() {
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        stopping = true;
+    }
+
+    worker_wake.notify_one();
+    thread.join();
+}
+
+void APUWorker::start(const APU& machine_apu) {
+    wait_until_idle();
+
+    apu = machine_apu;
+    apu.bus = nullptr;
+    apu.worker = nullptr;
+    apu.dmc_source = this;
+    apu.attach_audio_output(audio_output);
+
+    recording.writes.clear();
+    recording.dmc_bytes.clear();
+    dmc_bytes.clear();
+    next_dmc_index = 0;
+}
+
+void APUWorker::log_write(uint64_t cycle, uint16_t address, uint8_t value) {
+    recording.writes.push_back({cycle, address, value});
+}
+
+void APUWorker::log_dmc_byte(uint8_t value) {
+    recording.dmc_bytes.push_back(value);
+}
+
+void APUWorker::end_frame(uint64_t cycle) {
+    recording.end_cycle = cycle;
+
+    {
+        std::unique_lock<std::mutex> guard(lock);
+
+        if (has_pending) {
+            emulation_waits++;
+            frame_done.wait(guard, [this] { return !has_pending; });
+        }
+
+        // Swapping keeps both logs' allocations, so logging settles down to no allocations at all
+        std::swap(recording, pending);
+        has_pending = true;
+    }
+
+    worker_wake.notify_one();
+
+    recording.writes.clear();
+    recording.dmc_bytes.clear();
+}
+
+void APUWorker::wait_until_idle() {
+    std::unique_lock<std::mutex> guard(lock);
+    frame_done.wait(guard, [this] { return !has_pending; });
+}
+
+uint8_t APUWorker::next_dmc_byte() {
+    // Both APUs fetch at the same cycles, so this only runs dry if they disagree. Silence is the least bad answer then
+    if (next_dmc_index >= dmc_bytes.size()) {
+        return 0;
+    }
+
+    return dmc_bytes[next_dmc_index++];
+}
+
+void APUWorker::run() {
+    std::unique_lock<std::mutex> guard(lock);
+
+    while (true) {
+        worker_wake.wait(guard, [this] { return has_pending || stopping; });
+
+        if (!has_pending) {
+            return;
+        }
+
+        guard.unlock();
+        synthesize(pending);
+        guard.lock();
+
+        has_pending = false;
+        frames_synthesized++;
+        frame_done.notify_all();
+    }
+}
+
+void APUWorker::synthesize(const FrameLog& log) {
+    // A frame's first write can already need one of its bytes (enabling the DMC fetches straight away), so all of them
+    // are queued before replaying
+    dmc_bytes.erase(dmc_bytes.begin(), dmc_bytes.begin() + next_dmc_index);
+    dmc_bytes.insert(dmc_bytes.end(), log.dmc_bytes.begin(), log.dmc_bytes.end());
+    next_dmc_index = 0;
+
+    for (const RegisterWrite& write : log.writes) {
+        apu.run_until(write.cycle);
+        apu.write_register(write.address, write.value);
+    }
+
+    apu.run_until(log.end_cycle);
+}
@@ -0,0 +1,70 @@
+#include <algorithm>
+#include <cstring>
+
+#include "AudioRingBuffer.h"
+
+static size_t round_up_to_power_of_two(size_t value) {
+    size_t power = 1;
+
+    while (power < value) {
+        power <<= 1;
+    }
+
+    return power;
+}
+
+AudioRingBuffer::AudioRingBuffer(size_t capacity) : samples(round_up_to_power_of_two(std::max<size_t>(capacity, 1))) {
+    mask = samples.size() - 1;
+}
+
+size_t AudioRingBuffer::capacity() const {
+    return samples.size();
+}
+
+size_t AudioRingBuffer::size() const {
+    // Read the consumer's position first. The producer's can only have moved further since, so this never goes negative
+    size_t read_at = read_position.load(std::memory_order_acquire);
+    size_t write_at = write_position.load(std::memory_order_acquire);
+    return write_at - read_at;
+}
+
+size_t AudioRingBuffer::free_space() const {
+    return capacity() - size();
+}
+
+size_t AudioRingBuffer::write(const int16_t* data, size_t count) {
+    size_t write_at = write_position.load(std::memory_order_relaxed);
+    size_t read_at = read_position.load(std::memory_order_acquire);
+
+    count = std::min(count, capacity() - (write_at - read_at));
+
+    // The free space can wrap around the end of the buffer, so copy it in up to two pieces
+    size_t start = write_at & mask;
+    size_t first_part = std::min(count, capacity() - start);
+    std::memcpy(samples.data() + start, data, first_part * sizeof(int16_t));
+    std::memcpy(samples.data(), data + first_part, (count - first_part) * sizeof(int16_t));
+
+    // Publish the samples only once they are in place
+    write_position.store(write_at + count, std::memory_order_release);
+    return count;
+}
+
+size_t AudioRingBuffer::read(int16_t* data, size_t count) {
+    size_t read_at = read_position.load(std::memory_order_relaxed);
+    size_t write_at = write_position.load(std::memory_order_acquire);
+
+    count = std::min(count, write_at - read_at);
+
+    size_t start = read_at & mask;
+    size_t first_part = std::min(count, capacity() - start);
+    std::memcpy(data, samples.data() + start, first_part * sizeof(int16_t));
+    std::memcpy(data + first_part, samples.data(), (count - first_part) * sizeof(int16_t));
+
+    // Hand the space back to the producer only once the samples have been copied out
+    read_position.store(read_at + count, std::memory_order_release);
+    return count;
+}
+
+void AudioRingBuffer::clear() {
+    read_position.store(write_position.load(std::memory_order_acquire), std::memory_order_release);
+}
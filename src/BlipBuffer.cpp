@@ -0,0 +1,208 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "BlipBuffer.h"
+
+// The AVX2 path is compiled for AVX2 on its own, with a target attribute, and chosen at run time
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define BLIP_BUFFER_AVX2
+#endif
+
+#if defined(BLIP_BUFFER_AVX2) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+namespace {
+
+// Band-limited impulse for each sub-sample phase: a Blackman windowed sinc, cut off a little below Nyquist.
+// Each phase sums to 1, so a delta adds exactly its own size to the running sum
+struct StepKernel {
+    alignas(32) float taps[BlipBuffer::NUM_PHASES][BlipBuffer::KERNEL_TAPS];
+
+    StepKernel() {
+        const double PI = 3.14159265358979323846;
+        const double CUTOFF = 0.9;
+        const double HALF_WIDTH = BlipBuffer::KERNEL_TAPS / 2;
+
+        for (int phase = 0; phase < BlipBuffer::NUM_PHASES; phase++) {
+            double sum = 0;
+            double values[BlipBuffer::KERNEL_TAPS];
+
+            for (int tap = 0; tap < BlipBuffer::KERNEL_TAPS; tap++) {
+                // Distance from the step to this sample. Output is delayed by half the kernel, so no tap lands in the past
+                double x = tap - HALF_WIDTH + 1 - static_cast<double>(phase) / BlipBuffer::NUM_PHASES;
+                double sinc = x == 0 ? 1 : std::sin(PI * CUTOFF * x) / (PI * CUTOFF * x);
+                double window = 0.42 + 0.5 * std::cos(PI * x / HALF_WIDTH) + 0.08 * std::cos(2 * PI * x / HALF_WIDTH);
+
+                values[tap] = sinc * window;
+                sum += values[tap];
+            }
+
+            for (int tap = 0; tap < BlipBuffer::KERNEL_TAPS; tap++) {
+                taps[phase][tap] = static_cast<float>(values[tap] / sum);
+            }
+        }
+    }
+};
+
+const StepKernel& step_kernel() {
+    static const StepKernel kernel;
+    return kernel;
+}
+
+}
+
+BlipBuffer::BlipBuffer(double clock_rate, double sample_rate, size_t max_samples) : deltas(max_samples + KERNEL_TAPS, 0.0f) {
+    set_rates(clock_rate, sample_rate);
+}
+
+void BlipBuffer::set_rates(double clock_rate, double sample_rate) {
+    factor = static_cast<uint64_t>(sample_rate / clock_rate * (1ULL << FRAC_BITS) + 0.5);
+}
+
+bool BlipBuffer::has_avx2() {
+#if defined(BLIP_BUFFER_AVX2)
+    static const bool supported = (__builtin_cpu_init(), __builtin_cpu_supports("avx2"));
+    return supported;
+#else
+    return false;
+#endif
+}
+
+const char* BlipBuffer::vector_extension() {
+    if (has_avx2()) {
+        return "AVX2";
+    }
+
+#if defined(__SSE2__)
+    return "SSE2";
+#else
+    return "none";
+#endif
+}
+
+bool BlipBuffer::locate_delta(uint32_t clock_time, float*& out, const float*& kernel) {
+    uint64_t position = offset + clock_time * factor;
+    size_t index = position >> FRAC_BITS;
+
+    // Nobody is reading the samples. Drop the delta rather than writing past the buffer
+    if (index + KERNEL_TAPS > deltas.size()) {
+        return false;
+    }
+
+    int phase = (position >> (FRAC_BITS - PHASE_BITS)) & (NUM_PHASES - 1);
+    kernel = step_kernel().taps[phase];
+    out = deltas.data() + index;
+
+    return true;
+}
+
+void BlipBuffer::add_delta(uint32_t clock_time, int delta) {
+    if (has_avx2()) {
+        add_delta_avx2(clock_time, delta);
+    } else {
+        add_delta_sse2(clock_time, delta);
+    }
+}
+
+#if defined(BLIP_BUFFER_AVX2)
+__attribute__((target("avx2")))
+void BlipBuffer::add_delta_avx2(uint32_t clock_time, int delta) {
+    float* out;
+    const float* kernel;
+
+    if (!locate_delta(clock_time, out, kernel)) {
+        return;
+    }
+
+    // The whole kernel in two 8-wide multiply-adds. The kernel is aligned, the output isn't.
+    // No fused multiply-add, so it rounds exactly like the other paths
+    __m256 scale = _mm256_set1_ps(static_cast<float>(delta));
+
+    for (int tap = 0; tap < KERNEL_TAPS; tap += 8) {
+        __m256 sum = _mm256_add_ps(_mm256_loadu_ps(out + tap), _mm256_mul_ps(scale, _mm256_load_ps(kernel + tap)));
+        _mm256_storeu_ps(out + tap, sum);
+    }
+}
+#else
+void BlipBuffer::add_delta_avx2(uint32_t clock_time, int delta) {
+    add_delta_sse2(clock_time, delta);
+}
+#endif
+
+void BlipBuffer::add_delta_sse2(uint32_t clock_time, int delta) {
+#if defined(__SSE2__)
+    float* out;
+    const float* kernel;
+
+    if (!locate_delta(clock_time, out, kernel)) {
+        return;
+    }
+
+    // Four 4-wide multiply-adds
+    __m128 scale = _mm_set1_ps(static_cast<float>(delta));
+
+    for (int tap = 0; tap < KERNEL_TAPS; tap += 4) {
+        __m128 sum = _mm_add_ps(_mm_loadu_ps(out + tap), _mm_mul_ps(scale, _mm_load_ps(kernel + tap)));
+        _mm_storeu_ps(out + tap, sum);
+    }
+#else
+    add_delta_scalar(clock_time, delta);
+#endif
+}
+
+void BlipBuffer::add_delta_scalar(uint32_t clock_time, int delta) {
+    float* out;
+    const float* kernel;
+
+    if (!locate_delta(clock_time, out, kernel)) {
+        return;
+    }
+
+    for (int tap = 0; tap < KERNEL_TAPS; tap++) {
+        out[tap] += delta * kernel[tap];
+    }
+}
+
+void BlipBuffer::end_block(uint32_t num_clocks) {
+    offset += num_clocks * factor;
+}
+
+size_t BlipBuffer::samples_available() const {
+    return std::min<size_t>(offset >> FRAC_BITS, deltas.size() - KERNEL_TAPS);
+}
+
+size_t BlipBuffer::read_samples(int16_t* out, size_t max_samples) {
+    size_t count = std::min(max_samples, samples_available());
+
+    // Integrate the deltas, then remove DC so the output is centered on 0 whatever the channels' levels are
+    const float DC_BLOCK = 0.999f;
+
+    for (size_t i = 0; i < count; i++) {
+        integrator += deltas[i];
+
+        float output = integrator - last_input + DC_BLOCK * last_output;
+        last_input = integrator;
+        last_output = output;
+
+        out[i] = static_cast<int16_t>(std::max(-32768.0f, std::min(32767.0f, output)));
+    }
+
+    // Keep the deltas which belong to later samples
+    size_t remaining = deltas.size() - count;
+    std::memmove(deltas.data(), deltas.data() + count, remaining * sizeof(float));
+    std::fill(deltas.begin() + remaining, deltas.end(), 0.0f);
+
+    offset -= static_cast<uint64_t>(count) << FRAC_BITS;
+
+    return count;
+}
+
+void BlipBuffer::clear() {
+    std::fill(deltas.begin(), deltas.end(), 0.0f);
+    offset = 0;
+    integrator = 0;
+    last_input = 0;
+    last_output = 0;
+}
@@ -11,60 +11,116 @@ Bus::Bus() {
     apu->attach_bus(this);
 }
 
-Bus::Bus(bool ui_disabled) {
-    cpu = new CPU();
-    ppu = new PPU(ui_disabled);
-    io = new IO();
-    apu = new APU();
+Bus::Bus(const Bus& other) {
+    num_cpu_cycles = other.num_cpu_cycles;
+    cpu_RAM = other.cpu_RAM;
+    num_ticks = other.num_ticks;
+    cpu_open_bus = other.cpu_open_bus;
+    cpu_stall_cycles = other.cpu_stall_cycles;
+    is_nmi_line_low = other.is_nmi_line_low;
+    is_nmi_suppressed = other.is_nmi_suppressed;
+
+    cpu = new CPU(*other.cpu);
+    ppu = new PPU(*other.ppu);
+    io = new IO(*other.io);
+    apu = new APU(*other.apu);
     cpu->attach_bus(this);
     ppu->attach_bus(this);
     apu->attach_bus(this);
+
+    ppu->attach_video_output(nullptr);
+    apu->attach_audio_output(nullptr);
+
+    // The worker belongs to the original. Detaching through attach_worker would play out its log
+    apu->worker = nullptr;
+
+    if (other.cartridge != nullptr) {
+        owned_cartridge = std::make_unique<Cartridge>(*other.cartridge);
+        insert_cartridge(owned_cartridge.get());
+    }
+}
+
+std::unique_ptr<Bus> Bus::clone() const {
+    return std::make_unique<Bus>(*this);
+}
+
+Bus::~Bus() {
+    delete cpu;
+    delete ppu;
+    delete io;
+    delete apu;
 }
 
 uint8_t Bus::read_cpu(uint16_t address) {
     uint8_t data;
 
-    if (cartridge->read_cpu(address, data)) {
-        return data;
-    }
-
-    // Unused address space for now
-    if (address >= 0x4020 && address <= 0x5FFF) {
-        return 0;
+    // Most reads are RAM or ROM, so check those first
+    if (address <= RAM_MIRROR_END) {
+        cpu_open_bus = cpu_RAM[address & 0x7FF];
+        return cpu_open_bus;
     }
 
-    if (address >= RAM_MIRROR_START && address <= RAM_MIRROR_END) {
-        return cpu_RAM.at(address & 0x7FF);
+    if (cartridge->read_cpu(address, data)) {
+        cpu_open_bus = data;
+        return data;
     }
 
     if (address >= PPU_REG_MIRROR_START && address <= PPU_REG_MIRROR_END) {
-        return ppu->read_from_cpu(address);
+        cpu_open_bus = ppu->read_from_cpu(address);
+        return cpu_open_bus;
     }
 
     if (address >= APU_IO_REG_START && address <= APU_IO_REG_END) {
-        // TODO: Implement APU / IO registers
-
         if (address == 0x4016 || address == 0x4017) {
             // Reroute to IO
-            uint8_t status = io->read_from_cpu(address);
-            return status;
+            cpu_open_bus = io->read_from_cpu(address);
         } else {
             // Reroute to APU
-            return apu->read_from_cpu(address);
+            cpu_open_bus = apu->read_from_cpu(address);
         }
 
+        return cpu_open_bus;
     }
 
-    return cpu_RAM.at(address);
+    // Nothing drives the bus: unused address space, or 0x6000 - 0x7FFF on boards without PRG RAM (or with it disabled)
+    return cpu_open_bus;
+}
+
+const uint8_t* Bus::direct_page(uint8_t page) const {
+    uint16_t address = page << 8;
+
+    if (address <= RAM_MIRROR_END) {
+        return cpu_RAM.data() + (address & 0x7FF);
+    }
+
+    // PRG pages are 4 KB, so a 256 byte page never crosses into the next one
+    if (address >= 0x8000) {
+        return cartridge->prg_pages[(address - 0x8000) / Cartridge::PRG_PAGE_SIZE] + (address % Cartridge::PRG_PAGE_SIZE);
+    }
+
+    return nullptr;
 }
 
 void Bus::write_cpu(uint16_t address, uint8_t val) {
-    if (cartridge->write_cpu(address, val)) {
+    cpu_open_bus = val;
+
+    if (address <= RAM_MIRROR_END) {
+        cpu_RAM[address & 0x7FF] = val;
+        return;
+    }
+
+    if (address >= 0x8000) {
+        // Mapper registers. Acknowledging the mapper's IRQ releases only its hold on the line
+        bool mapper_irq_was_pending = cartridge->mapper->irq_pending;
+        cartridge->write_cpu(address, val);
+
+        if (mapper_irq_was_pending && !cartridge->mapper->irq_pending) {
+            cpu->release_IRQ(IRQ_MAPPER);
+        }
         return;
     }
 
-    if (address >= RAM_MIRROR_START && address <= RAM_MIRROR_END) {
-        cpu_RAM.at(address & 0x7FF) = val;
+    if (cartridge->write_cpu(address, val)) {
         return;
     }
 
@@ -76,6 +132,10 @@ void Bus::write_cpu(uint16_t address, uint8_t val) {
     // OAM DMA register
     if (address == 0x4014) {
         ppu->load_OAMDMA(val);
+
+        // The copy happens at once, and the CPU just sits out the cycles the DMA would have taken.
+        // Starting on an odd cycle costs one more, to line the reads and writes up
+        stall_cpu(OAM_DMA_CYCLES + (cpu_write_cycle() % 2));
         return;
     }
 
@@ -103,15 +163,35 @@ void Bus::reset() {
     ppu->reset();
 }
 
-void Bus::tick() {
+void Bus::stall_cpu(uint32_t cycles) {
+    cpu_stall_cycles += cycles;
+}
 
-    if (num_ticks % 3 == 0) {
+uint64_t Bus::cpu_write_cycle() const {
+    // Inside the instruction, clock_cycles_remaining still counts its first cycle, which is num_cpu_cycles
+    return num_cpu_cycles + (cpu->clock_cycles_remaining > 0 ? cpu->clock_cycles_remaining - 1 : 0);
+}
+
+void Bus::tick_cpu() {
+    // DMA only takes the bus between instructions, and the rest of the machine carries on meanwhile
+    if (cpu_stall_cycles > 0 && cpu->clock_cycles_remaining == 0) {
+        cpu_stall_cycles--;
+    } else {
         cpu->tick();
-        num_cpu_cycles++;
     }
 
-    if (num_ticks % 6 == 0) {
-        apu->tick();
+    num_cpu_cycles++;
+
+    // The APU runs behind the CPU, and is only caught up when it has something to do (see APU::run_until)
+    if (num_cpu_cycles >= apu->next_event_cycle) {
+        apu->run_until(num_cpu_cycles);
+    }
+}
+
+void Bus::tick() {
+
+    if (num_ticks % 3 == 0) {
+        tick_cpu();
     }
 
     ppu->tick();
@@ -119,6 +199,14 @@ void Bus::tick() {
     num_ticks++;
 }
 
+void Bus::run_frame() {
+    uint16_t cur_frame = ppu->frames_elapsed;
+
+    while (ppu->frames_elapsed == cur_frame) {
+        tick();
+    }
+}
+
 void Bus::halt() {
     throw std::runtime_error("Execution halted at " + std::to_string(cpu->program_counter));
 }
@@ -152,4 +240,82 @@ bool Bus::is_open_bus(uint16_t addr) const {
     }
 
     return false;
-}
\ No newline at end of file
+}
+
+void Bus::save_state(std::vector<uint8_t>& buffer) const {
+    StateWriter state(buffer);
+
+    state.write(SAVE_STATE_MAGIC);
+    state.write(SAVE_STATE_VERSION);
+
+    state.write_vector(cpu_RAM);
+    state.write(num_cpu_cycles);
+    state.write(num_ticks);
+    state.write(cpu_open_bus);
+    state.write(cpu_stall_cycles);
+    state.write(is_nmi_line_low);
+    state.write(is_nmi_suppressed);
+
+    cpu->save_state(state);
+    ppu->save_state(state);
+    apu->save_state(state);
+    io->save_state(state);
+    cartridge->save_state(state);
+}
+
+uint64_t Bus::hash_frame() const {
+    return hash_bytes(ppu->screen.pixels.data(), ppu->screen.pixels.size());
+}
+
+uint64_t Bus::hash_state() const {
+    StreamingHash hash;
+    StateWriter state(hash);
+
+    state.write_vector(cpu_RAM);
+    state.write(num_cpu_cycles);
+    state.write(num_ticks);
+    state.write(cpu_open_bus);
+    state.write(cpu_stall_cycles);
+    state.write(is_nmi_line_low);
+    state.write(is_nmi_suppressed);
+
+    cpu->save_state(state);
+    ppu->save_state(state);
+    apu->save_state(state);
+    io->save_state(state);
+    cartridge->save_state(state);
+
+    return hash.digest();
+}
+
+void Bus::load_state(const uint8_t* data, size_t size) {
+    StateReader state(data, size);
+
+    uint32_t magic;
+    uint32_t version;
+
+    state.read(magic);
+    state.read(version);
+
+    if (magic != SAVE_STATE_MAGIC) {
+        throw std::runtime_error("Not a save state");
+    }
+
+    if (version != SAVE_STATE_VERSION) {
+        throw std::runtime_error("Unsupported save state version " + std::to_string(version));
+    }
+
+    state.read_vector(cpu_RAM);
+    state.read(num_cpu_cycles);
+    state.read(num_ticks);
+    state.read(cpu_open_bus);
+    state.read(cpu_stall_cycles);
+    state.read(is_nmi_line_low);
+    state.read(is_nmi_suppressed);
+
+    cpu->load_state(state);
+    ppu->load_state(state);
+    apu->load_state(state);
+    io->load_state(state);
+    cartridge->load_state(state);
+}
@@ -5,6 +5,7 @@
 
 #include "CPU.h"
 #include "Helpers.h"
+#include "SaveState.h"
 
 /*
 BCC - Branch if Carry Clear
@@ -2280,25 +2281,22 @@ void CPU::tick() {
         execute_opcode(program_counter);
 
         if (nmi_flag) {
-            
-            // Handling NMI resets IRQ status
-            irq_pending = false;
-
             nmi_flag = false;
             clock_cycles_remaining += 8;
                         
             stack_push(program_counter);
-            set_flag(INT_DISABLE, 1);
             set_flag(BREAK, 0);
             stack_push(get_byte_from_flags());
+
+            // The pushed flags keep the interrupted code's I flag, so RTI restores it
+            set_flag(INT_DISABLE, 1);
             uint16_t nmi_interrput_address = form_address(bus->read_cpu(0xFFFA), bus->read_cpu(0xFFFB));
 
             nmi_latch_set = false;
 
             program_counter = nmi_interrput_address;
-        } else if (irq_pending && !get_flag(INT_DISABLE)) {
-            irq_pending = false;
-
+        } else if (irq_sources != 0 && !get_flag(INT_DISABLE)) {
+            // The line stays held until its sources are acknowledged, so the handler runs again on RTI if they aren't
             set_flag(BREAK, 0);
 
             stack_push(program_counter);
@@ -2333,8 +2331,10 @@ void CPU::execute_next_opcode() {
 
     execute_opcode(program_counter);
 
-    num_clock_cycles += clock_cycles_remaining;
+    // DMA the instruction started is skipped over along with it
+    num_clock_cycles += clock_cycles_remaining + bus->cpu_stall_cycles;
     clock_cycles_remaining = 0;
+    bus->cpu_stall_cycles = 0;
 }
 
 void CPU::stack_push(uint8_t new_val) {
@@ -2383,10 +2383,56 @@ void CPU::check_nmi_edge() {
     is_nmi_line_low = cur_nmi_line_status;
 }
 
-void CPU::trigger_IRQ() {
-    irq_pending = true;
+void CPU::assert_IRQ(irq_source source) {
+    irq_sources |= source;
+}
+
+void CPU::release_IRQ(irq_source source) {
+    irq_sources &= ~source;
 }
 
 void CPU::reset_IRQ() {
-    irq_pending = false;
-}
\ No newline at end of file
+    irq_sources = 0;
+}
+
+void CPU::save_state(StateWriter& state) const {
+    state.write(num_clock_cycles);
+    state.write(clock_cycles_remaining);
+    state.write(num_opcodes_executed);
+
+    state.write(nmi_latch_set);
+    state.write(nmi_edge_detected_last_cycle);
+    state.write(nmi_flag);
+    state.write(nmi_next);
+    state.write(is_nmi_line_low);
+    state.write(nmi_edge_detected);
+    state.write(irq_sources);
+
+    state.write(stack_pointer);
+    state.write(program_counter);
+    state.write(A);
+    state.write(X);
+    state.write(Y);
+    state.write(flags);
+}
+
+void CPU::load_state(StateReader& state) {
+    state.read(num_clock_cycles);
+    state.read(clock_cycles_remaining);
+    state.read(num_opcodes_executed);
+
+    state.read(nmi_latch_set);
+    state.read(nmi_edge_detected_last_cycle);
+    state.read(nmi_flag);
+    state.read(nmi_next);
+    state.read(is_nmi_line_low);
+    state.read(nmi_edge_detected);
+    state.read(irq_sources);
+
+    state.read(stack_pointer);
+    state.read(program_counter);
+    state.read(A);
+    state.read(X);
+    state.read(Y);
+    state.read(flags);
+}
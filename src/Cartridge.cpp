@@ -1,105 +1,211 @@
 
-#include <fstream>
 #include <iostream>
 #include <stdexcept>
 
 #include "Cartridge.h"
 #include "Helpers.h"
+#include "SaveFile.h"
+#include "mappers/DiscreteMapper.h"
 #include "mappers/Mapper000.h"
 #include "mappers/Mapper001.h"
 #include "mappers/Mapper003.h"
+#include "mappers/Mapper004.h"
+#include "mappers/Mapper031.h"
 
 using std::vector;
 
 Cartridge::Cartridge(const std::string& rom_file_name) {
-    std::ifstream rom_file("roms/" + rom_file_name, std::ios::binary);
+    // We don't need to use size_t because string::npos is -1
+    int extension_pos_start = rom_file_name.find('.');
 
-    if (!rom_file.is_open()) {
-        throw std::runtime_error("Failed to open file");
+    if (extension_pos_start == std::string::npos) {
+        throw std::runtime_error("The file name is formatted incorrectly. Be sure to add a file extension");
     }
 
-    // We don't need to use size_t because string::npos is -1
-    int extension_pos_start = rom_file_name.find('.');
+    std::string extension = rom_file_name.substr(extension_pos_start + 1);
 
-    std::vector<uint8_t> file_header(16);
+    if (extension != "nes") {
+        throw std::runtime_error("Unsupported ROM format");
+    }
 
-    std::vector<uint8_t> rom_data;
+    std::shared_ptr<const MappedFile> rom_file = std::make_shared<MappedFile>("roms/" + rom_file_name);
 
+    load_ines(rom_file->data, rom_file->size, rom_file);
+}
 
-    if (extension_pos_start == std::string::npos) {
-        throw std::runtime_error("The file name is formatted incorrectly. Be sure to add a file extension");
-        return;
+Cartridge::Cartridge(const uint8_t* rom_data, size_t rom_size) {
+    load_ines(rom_data, rom_size);
+}
+
+void Cartridge::load_ines(const uint8_t* rom_data, size_t rom_size, std::shared_ptr<const MappedFile> mapping) {
+    header = INESHeader(rom_data, rom_size);
+
+    if (header.has_four_screen_vram) {
+        set_mirroring(FOUR_SCREEN);
+    } else if (header.has_vertical_mirroring) {
+        set_mirroring(VERTICAL);
     } else {
-        std::string extension = rom_file_name.substr(extension_pos_start + 1);
+        set_mirroring(HORIZONTAL);
+    }
 
-        if (extension == "nes") {
-            // iNES format, file header is 16 bytes
+    // The trainer sits between the header and PRG ROM. Nothing we support uses it, so skip over it
+    size_t prg_rom_start = header.prg_rom_offset();
+    size_t chr_rom_start = prg_rom_start + header.prg_rom_size;
 
-            // We need to read in one byte at a time. However the ifstream.get method is not overloaded to work with uint8_t
-            // types. Chars are also one byte big so these will work fine
-            char cur_byte;
-            for (int i = 0; i < 16; i++) {
-                rom_file.get(cur_byte);
-                file_header.at(i) = cur_byte;
-            }
+    if (rom_size < chr_rom_start || rom_size - chr_rom_start < header.chr_rom_size) {
+        throw std::runtime_error("ROM is smaller than its header says");
+    }
 
-            const int NUM_PRG_BANKS = file_header.at(4);
-            const int NUM_CHR_BANKS = file_header.at(5);
+    if (header.prg_rom_size == 0 || header.prg_rom_size % PRG_PAGE_SIZE != 0) {
+        throw std::runtime_error("PRG ROM size must be a multiple of 4 KB");
+    }
 
-            // The PRG RAM size is rarely set in iNES files.
-            // So if the PRG RAM size is 0, by default set it to 1 bank instead (even if the mapper doesn't support PRG RAM)
-            const int NUM_PRG_RAM_BANKS = file_header.at(8) > 0 ? file_header.at(8) : 1;
+    // Cartridges with the same ROM share one image, only RAM is per cartridge
+    rom = RomImage::load(rom_data + prg_rom_start, header.prg_rom_size, rom_data + chr_rom_start, header.chr_rom_size, mapping);
 
-            const int PRG_ROM_SIZE = file_header.at(4) * PRG_ROM_PAGE_SIZE;
-            const int CHR_ROM_SIZE = file_header.at(5) * CHR_ROM_PAGE_SIZE;
+    CHR_RAM = CowBuffer(header.chr_ram_size + header.chr_nvram_size);
 
-            bool has_trainer = is_bit_set(2, file_header.at(6));
-            
-            if (is_bit_set(0, file_header.at(6))) {
-                mirroring_type = VERTICAL;
-            } else {
-                mirroring_type = HORIZONTAL;
-            }
+    size_t chr_size = header.chr_rom_size > 0 ? header.chr_rom_size : CHR_RAM.size();
 
-            if (has_trainer) {
-                std::cerr << "Trainers are not supported yet" << std::endl;
-            } else {
-                for (int i = 0; i < PRG_ROM_SIZE; i++) {
-                    rom_file.get(cur_byte);
-                    PRG_ROM.push_back(static_cast<uint8_t>(cur_byte));
-                }
+    if (chr_size == 0 || chr_size % CHR_PAGE_SIZE != 0) {
+        throw std::runtime_error("CHR ROM or CHR RAM size must be a multiple of 1 KB");
+    }
+
+    const int NUM_PRG_BANKS = header.prg_rom_size / INESHeader::PRG_ROM_UNIT;
+    const int NUM_CHR_BANKS = header.chr_rom_size / INESHeader::CHR_ROM_UNIT;
+    const size_t PRG_RAM_SIZE = header.prg_ram_size + header.prg_nvram_size;
+
+    switch (header.mapper_number) {
+        case 0:
+            this->mapper = new Mapper000(NUM_PRG_BANKS, 0, NUM_CHR_BANKS);
+            break;
+        case 1:
+            this->mapper = new Mapper001(NUM_PRG_BANKS, PRG_RAM_SIZE, NUM_CHR_BANKS);
+            break;
+        case 2:
+            this->mapper = new Mapper002(NUM_PRG_BANKS, NUM_CHR_BANKS);
+            break;
+        case 3:
+            this->mapper = new Mapper003(NUM_PRG_BANKS, NUM_CHR_BANKS);
+            break;
+        case 4:
+            this->mapper = new Mapper004(NUM_PRG_BANKS, PRG_RAM_SIZE, NUM_CHR_BANKS);
+            break;
+        case 7:
+            this->mapper = new Mapper007(NUM_PRG_BANKS, NUM_CHR_BANKS);
+            // The latch powers up as 0, selecting the first nametable
+            set_mirroring(SINGLE_SCREEN_A);
+            break;
+        case 11:
+            this->mapper = new Mapper011(NUM_PRG_BANKS, NUM_CHR_BANKS);
+            break;
+        case 31:
+            this->mapper = new Mapper031(NUM_PRG_BANKS, PRG_RAM_SIZE, NUM_CHR_BANKS);
+            break;
+        case 66:
+            this->mapper = new Mapper066(NUM_PRG_BANKS, NUM_CHR_BANKS);
+            break;
+        case 71:
+            this->mapper = new Mapper071(NUM_PRG_BANKS, NUM_CHR_BANKS);
+            break;
+        default:
+            throw std::runtime_error("Mapper not supported: " + std::to_string(header.mapper_number));
+            break;
+    }
+
+    mapper->attach_cartridge(this);
+    refresh_prg_pages();
+    refresh_chr_pages();
+}
+
+Cartridge::Cartridge(const Cartridge& other) : header(other.header), rom(other.rom), CHR_RAM(other.CHR_RAM) {
+    set_mirroring(other.mirroring_type);
+    mapper = other.mapper->clone();
+    mapper->attach_cartridge(this);
+    refresh_prg_pages();
+    refresh_chr_pages();
+}
+
+Cartridge::~Cartridge() {
+    delete mapper;
+}
+
+void Cartridge::attach_save_file(const std::string& path) {
+    if (!header.has_battery || mapper->PRG_RAM.size() == 0) {
+        return;
+    }
+
+    // The whole PRG RAM is kept in the file, even on the rare boards which also have some RAM without a battery
+    std::shared_ptr<SaveFile> save_file = std::make_shared<SaveFile>(path, mapper->PRG_RAM.size());
 
-                for (int i = 0; i < CHR_ROM_SIZE; i++) {
-                    rom_file.get(cur_byte);
-                    CHR_ROM.push_back(static_cast<uint8_t>(cur_byte));
+    // The buffer keeps the save file alive, so it is synced once the mapper is gone
+    mapper->PRG_RAM = CowBuffer(std::shared_ptr<uint8_t>(save_file, save_file->data), save_file->size);
+}
+
+    void Cartridge::set_mirroring(MIRRORING_TYPE new_mirroring_type) {
+        mirroring_type = new_mirroring_type;
+
+        // The PPU has 2 KB of its own VRAM. Four screen boards add another 2 KB, which sits after it
+        switch (mirroring_type) {
+            case HORIZONTAL:
+                nametable_pages[0] = 0;
+                nametable_pages[1] = 0;
+                nametable_pages[2] = NAMETABLE_SIZE;
+                nametable_pages[3] = NAMETABLE_SIZE;
+                break;
+            case VERTICAL:
+                nametable_pages[0] = 0;
+                nametable_pages[1] = NAMETABLE_SIZE;
+                nametable_pages[2] = 0;
+                nametable_pages[3] = NAMETABLE_SIZE;
+                break;
+            case FOUR_SCREEN:
+                for (int page = 0; page < 4; page++) {
+                    nametable_pages[page] = page * NAMETABLE_SIZE;
                 }
-            }
+                break;
+            case SINGLE_SCREEN_A:
+            case SINGLE_SCREEN_B:
+                for (int page = 0; page < 4; page++) {
+                    nametable_pages[page] = mirroring_type == SINGLE_SCREEN_B ? NAMETABLE_SIZE : 0;
+                }
+                break;
+            default:
+                throw std::runtime_error("Unknown mirroring type on cartridge");
+        }
+    }
 
-            uint8_t mapper_number = (file_header.at(5) & 0xF0) | ((file_header.at(6) & 0xF0) >> 4);
-
-            switch (mapper_number) {
-                case 0:
-                    this->mapper = new Mapper000(NUM_PRG_BANKS, NUM_PRG_RAM_BANKS, NUM_CHR_BANKS);
-                    break;
-                case 1:
-                    this->mapper = new Mapper001(NUM_PRG_BANKS, NUM_PRG_RAM_BANKS, NUM_CHR_BANKS);
-                    break;
-                case 3:
-                    this->mapper = new Mapper003(NUM_PRG_BANKS, NUM_CHR_BANKS);
-                    break;
-                default:
-                    throw std::runtime_error("Mapper not supported: " + std::to_string(mapper_number));
-                    break;
-            }
-        } else {
-            throw std::runtime_error("Unsupported ROM format");
-            return;
+    void Cartridge::refresh_prg_pages() {
+        for (int page = 0; page < NUM_PRG_PAGES; page++) {
+            uint16_t page_address = 0x8000 + page * PRG_PAGE_SIZE;
+            uint32_t mapped_address = page_address;
+            uint8_t unused;
+
+            mapper->cpu_mapper_read(page_address, mapped_address, unused);
+
+            // Bank numbers past the end of the ROM wrap around, like on real boards
+            prg_pages[page] = rom->PRG_ROM.data() + (mapped_address % rom->PRG_ROM.size());
         }
     }
-}
 
+    bool Cartridge::read_prg_through_mapper(uint16_t address, uint8_t& data) {
+        uint32_t mapped_address = address;
+
+        if (mapper->cpu_mapper_read(address, mapped_address, data)) {
+            data = rom->PRG_ROM[mapped_address % rom->PRG_ROM.size()];
+            return true;
+        }
+
+        return false;
+    }
 
     bool Cartridge::read_cpu(uint16_t address, uint8_t& data) {
+        // PRG ROM
+        if (address >= 0x8000) {
+            data = prg_pages[(address - 0x8000) / PRG_PAGE_SIZE][address % PRG_PAGE_SIZE];
+            return true;
+        }
+
         uint32_t mapped_address = address;
 
         // Return true if we access PRG RAM data
@@ -110,7 +216,7 @@ Cartridge::Cartridge(const std::string& rom_file_name) {
 
         // Return true if we access PRG ROM data
         if (mapper->cpu_mapper_read(address, mapped_address, data)) {
-            data = PRG_ROM[mapped_address];
+            data = rom->PRG_ROM[mapped_address];
             return true;
         }
 
@@ -126,31 +232,68 @@ Cartridge::Cartridge(const std::string& rom_file_name) {
             return true;
         }
 
-        // Return true if we write to PRG ROM data (excluding PRG RAM)
-        if (mapper->cpu_mapper_write(address, mapped_address, data)) {
-            PRG_ROM[mapped_address] = data;
-            return true;
+        // Writes to PRG ROM space go to mapper registers. ROM itself is never written
+        bool handled = mapper->cpu_mapper_write(address, mapped_address, data);
+
+        // Only refresh the page tables the write actually changed
+        if (mapper->prg_banks_changed) {
+            refresh_prg_pages();
+            mapper->prg_banks_changed = false;
         }
 
-        return false;
+        if (mapper->chr_banks_changed) {
+            refresh_chr_pages();
+            mapper->chr_banks_changed = false;
+        }
+
+        return handled;
     }
 
-    bool Cartridge::read_ppu(uint16_t address) {
-        uint32_t mapped_address = address;
+    void Cartridge::refresh_chr_pages() {
+        for (int page = 0; page < NUM_CHR_PAGES; page++) {
+            uint16_t page_address = page * CHR_PAGE_SIZE;
+            uint32_t mapped_address = page_address;
 
-        if (mapper->ppu_mapper_read(address, mapped_address)) {
-            return true;
-        }
+            mapper->ppu_mapper_read(page_address, mapped_address);
 
-        return false;
+            // Bank numbers past the end of CHR wrap around
+            if (rom->CHR_ROM.size() > 0) {
+                chr_pages[page] = rom->CHR_ROM.data() + (mapped_address % rom->CHR_ROM.size());
+            } else {
+                chr_pages[page] = CHR_RAM.data() + (mapped_address % CHR_RAM.size());
+            }
+        }
     }
 
-    bool Cartridge::write_ppu(uint16_t address, uint8_t data) {
+    void Cartridge::write_ppu(uint16_t address, uint8_t data) {
         uint32_t mapped_address = address;
 
-        if (mapper->ppu_mapper_write(address, mapped_address, data)) {
-            return true;
+        // CHR ROM is unwriteable
+        if (!mapper->ppu_mapper_write(address, mapped_address, data) || CHR_RAM.size() == 0) {
+            return;
         }
 
-        return false;
-    }
\ No newline at end of file
+        const uint8_t* shared_memory = CHR_RAM.data();
+        CHR_RAM.set(mapped_address % CHR_RAM.size(), data);
+
+        // If the write took a private copy of CHR RAM, the page table still points at the shared one
+        if (CHR_RAM.data() != shared_memory) {
+            refresh_chr_pages();
+        }
+    }
+
+    void Cartridge::save_state(StateWriter& state) const {
+        state.write(mirroring_type);
+        state.write_buffer(CHR_RAM.data(), CHR_RAM.size());
+        mapper->save_state(state);
+    }
+
+    void Cartridge::load_state(StateReader& state) {
+        MIRRORING_TYPE saved_mirroring_type;
+        state.read(saved_mirroring_type);
+        set_mirroring(saved_mirroring_type);
+        state.read_buffer(CHR_RAM.mutable_data(), CHR_RAM.size());
+        mapper->load_state(state);
+        refresh_prg_pages();
+        refresh_chr_pages();
+    }
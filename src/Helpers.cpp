@@ -1,5 +1,6 @@
 
 #include <cstdint>
+#include <cstring>
 #include <sstream>
 #include <iomanip>
 #include "Helpers.h"
@@ -33,4 +34,130 @@ std::string get_hex_string(uint16_t value, int num_digits) {
     }
 
     return str;
-}
\ No newline at end of file
+}
+
+namespace {
+    const uint64_t PRIME_1 = 0x9E3779B185EBCA87;
+    const uint64_t PRIME_2 = 0xC2B2AE3D27D4EB4F;
+    const uint64_t PRIME_3 = 0x165667B19E3779F9;
+    const uint64_t PRIME_4 = 0x85EBCA77C2B2AE63;
+    const uint64_t PRIME_5 = 0x27D4EB2F165667C5;
+
+    uint64_t rotate_left(uint64_t value, int bits) {
+        return (value << bits) | (value >> (64 - bits));
+    }
+
+    // Little-endian loads, like the save states
+    uint64_t read_64(const uint8_t* bytes) {
+        uint64_t value;
+        std::memcpy(&value, bytes, sizeof(value));
+        return value;
+    }
+
+    uint32_t read_32(const uint8_t* bytes) {
+        uint32_t value;
+        std::memcpy(&value, bytes, sizeof(value));
+        return value;
+    }
+
+    uint64_t mix_lane(uint64_t accumulator, uint64_t lane) {
+        accumulator += lane * PRIME_2;
+        accumulator = rotate_left(accumulator, 31);
+        return accumulator * PRIME_1;
+    }
+
+    uint64_t merge_accumulator(uint64_t hash, uint64_t accumulator) {
+        hash ^= mix_lane(0, accumulator);
+        return hash * PRIME_1 + PRIME_4;
+    }
+
+    void consume_stripe(uint64_t* accumulators, const uint8_t* bytes) {
+        for (int lane = 0; lane < 4; lane++) {
+            accumulators[lane] = mix_lane(accumulators[lane], read_64(bytes + 8 * lane));
+        }
+    }
+}
+
+StreamingHash::StreamingHash(uint64_t hash_seed) : seed(hash_seed) {
+    accumulators[0] = seed + PRIME_1 + PRIME_2;
+    accumulators[1] = seed + PRIME_2;
+    accumulators[2] = seed;
+    accumulators[3] = seed - PRIME_1;
+}
+
+void StreamingHash::update(const uint8_t* data, size_t length) {
+    total_length += length;
+
+    if (stripe_length + length < sizeof(stripe)) {
+        std::memcpy(stripe + stripe_length, data, length);
+        stripe_length += length;
+        return;
+    }
+
+    if (stripe_length > 0) {
+        size_t fill = sizeof(stripe) - stripe_length;
+        std::memcpy(stripe + stripe_length, data, fill);
+        consume_stripe(accumulators, stripe);
+        data += fill;
+        length -= fill;
+        stripe_length = 0;
+    }
+
+    // Whole stripes are read straight from the input
+    for (; length >= sizeof(stripe); data += sizeof(stripe), length -= sizeof(stripe)) {
+        consume_stripe(accumulators, data);
+    }
+
+    std::memcpy(stripe, data, length);
+    stripe_length = length;
+}
+
+uint64_t StreamingHash::digest() const {
+    uint64_t hash;
+
+    if (total_length >= sizeof(stripe)) {
+        hash = rotate_left(accumulators[0], 1) + rotate_left(accumulators[1], 7) + rotate_left(accumulators[2], 12) + rotate_left(accumulators[3], 18);
+
+        for (uint64_t accumulator : accumulators) {
+            hash = merge_accumulator(hash, accumulator);
+        }
+    } else {
+        hash = seed + PRIME_5;
+    }
+
+    hash += total_length;
+
+    const uint8_t* tail = stripe;
+    size_t remaining = stripe_length;
+
+    for (; remaining >= 8; tail += 8, remaining -= 8) {
+        hash ^= mix_lane(0, read_64(tail));
+        hash = rotate_left(hash, 27) * PRIME_1 + PRIME_4;
+    }
+
+    if (remaining >= 4) {
+        hash ^= read_32(tail) * PRIME_1;
+        hash = rotate_left(hash, 23) * PRIME_2 + PRIME_3;
+        tail += 4;
+        remaining -= 4;
+    }
+
+    for (; remaining > 0; tail++, remaining--) {
+        hash ^= *tail * PRIME_5;
+        hash = rotate_left(hash, 11) * PRIME_1;
+    }
+
+    hash ^= hash >> 33;
+    hash *= PRIME_2;
+    hash ^= hash >> 29;
+    hash *= PRIME_3;
+    hash ^= hash >> 32;
+
+    return hash;
+}
+
+uint64_t hash_bytes(const uint8_t* data, size_t length, uint64_t seed) {
+    StreamingHash hash(seed);
+    hash.update(data, length);
+    return hash.digest();
+}
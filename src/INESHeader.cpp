@@ -0,0 +1,79 @@
+#include <stdexcept>
+
+#include "INESHeader.h"
+#include "Helpers.h"
+
+// NES 2.0 ROM sizes are either a count of units, or for odd sizes 2^E * (MM * 2 + 1) bytes
+static size_t nes2_rom_size(uint8_t lsb, uint8_t msb_nibble, size_t unit) {
+    if (msb_nibble == 0xF) {
+        uint8_t exponent = lsb >> 2;
+        uint8_t multiplier = lsb & 0x3;
+
+        if (exponent > 40) {
+            throw std::runtime_error("ROM size in header is too large");
+        }
+
+        return (static_cast<size_t>(1) << exponent) * (multiplier * 2 + 1);
+    }
+
+    return ((msb_nibble << 8) | lsb) * unit;
+}
+
+// NES 2.0 RAM sizes are given as a shift count: 64 << n bytes, or nothing if n is 0
+static size_t nes2_ram_size(uint8_t shift_count) {
+    return shift_count == 0 ? 0 : static_cast<size_t>(64) << shift_count;
+}
+
+INESHeader::INESHeader(const uint8_t* data, size_t size) {
+    if (size < SIZE || data[0] != 'N' || data[1] != 'E' || data[2] != 'S' || data[3] != 0x1A) {
+        throw std::runtime_error("ROM is not in the iNES format");
+    }
+
+    has_vertical_mirroring = is_bit_set(0, data[6]);
+    has_battery = is_bit_set(1, data[6]);
+    has_trainer = is_bit_set(2, data[6]);
+    has_four_screen_vram = is_bit_set(3, data[6]);
+
+    is_nes2 = (data[7] & 0x0C) == 0x08;
+
+    if (is_nes2) {
+        mapper_number = (data[6] >> 4) | (data[7] & 0xF0) | ((data[8] & 0x0F) << 8);
+        submapper_number = data[8] >> 4;
+
+        prg_rom_size = nes2_rom_size(data[4], data[9] & 0x0F, PRG_ROM_UNIT);
+        chr_rom_size = nes2_rom_size(data[5], data[9] >> 4, CHR_ROM_UNIT);
+
+        prg_ram_size = nes2_ram_size(data[10] & 0x0F);
+        prg_nvram_size = nes2_ram_size(data[10] >> 4);
+        chr_ram_size = nes2_ram_size(data[11] & 0x0F);
+        chr_nvram_size = nes2_ram_size(data[11] >> 4);
+    } else {
+        // Some old dumps have garbage (e.g. "DiskDude!") in bytes 7-15, which we can spot because bytes 12-15 should be zero.
+        // Only the low nibble of the mapper number can be trusted then
+        bool has_clean_header = data[12] == 0 && data[13] == 0 && data[14] == 0 && data[15] == 0;
+        mapper_number = (data[6] >> 4) | (has_clean_header ? data[7] & 0xF0 : 0);
+
+        prg_rom_size = data[4] * PRG_ROM_UNIT;
+        chr_rom_size = data[5] * CHR_ROM_UNIT;
+
+        // The PRG RAM size is rarely set, so 0 means 1 bank
+        size_t prg_ram_banks = (has_clean_header && data[8] > 0) ? data[8] : 1;
+
+        if (has_battery) {
+            prg_nvram_size = prg_ram_banks * PRG_RAM_UNIT;
+        } else {
+            prg_ram_size = prg_ram_banks * PRG_RAM_UNIT;
+        }
+
+        chr_ram_size = chr_rom_size == 0 ? CHR_ROM_UNIT : 0;
+    }
+
+    // Boards without CHR ROM always have some CHR RAM, even if the header forgot to say so
+    if (chr_rom_size == 0 && chr_ram_size == 0 && chr_nvram_size == 0) {
+        chr_ram_size = CHR_ROM_UNIT;
+    }
+}
+
+size_t INESHeader::prg_rom_offset() const {
+    return SIZE + (has_trainer ? TRAINER_SIZE : 0);
+}
@@ -5,6 +5,31 @@
 
 #include "IO.h"
 
+// Copy a connected controller's state into a virtual one. Controllers which aren't virtual start out idle
+static void copy_controller(const Controller* source, VirtualController& destination) {
+    const VirtualController* source_virtual = dynamic_cast<const VirtualController*>(source);
+
+    if (source_virtual != nullptr) {
+        destination.buttons = source_virtual->buttons;
+        destination.controller_state = source_virtual->controller_state;
+    }
+
+    destination.is_strobing = source->is_strobing;
+}
+
+IO::IO(const IO& other) : strobe_mode(other.strobe_mode) {
+    if (other.port1_controller != nullptr) {
+        copy_controller(other.port1_controller, default_controller);
+    } else {
+        port1_controller = nullptr;
+    }
+
+    if (other.port2_controller != nullptr) {
+        copy_controller(other.port2_controller, port2_default_controller);
+        port2_controller = &port2_default_controller;
+    }
+}
+
 void IO::connect_controller(Controller* controller, uint8_t port_num) {
     if (port_num == 1) {
         port1_controller = controller;
@@ -51,4 +76,28 @@ void IO::write_from_cpu(uint16_t address, uint8_t val) {
         // Invalid write!
         throw std::runtime_error("Attempted to write to address unwriteable by IO");
     }
-}
\ No newline at end of file
+}
+
+void IO::save_state(StateWriter& state) const {
+    state.write(strobe_mode);
+
+    if (port1_controller != nullptr) {
+        port1_controller->save_state(state);
+    }
+
+    if (port2_controller != nullptr) {
+        port2_controller->save_state(state);
+    }
+}
+
+void IO::load_state(StateReader& state) {
+    state.read(strobe_mode);
+
+    if (port1_controller != nullptr) {
+        port1_controller->load_state(state);
+    }
+
+    if (port2_controller != nullptr) {
+        port2_controller->load_state(state);
+    }
+}
@@ -0,0 +1,39 @@
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "MappedFile.h"
+
+MappedFile::MappedFile(const std::string& path) {
+    int fd = open(path.c_str(), O_RDONLY);
+
+    if (fd < 0) {
+        throw std::runtime_error("Failed to open file " + path);
+    }
+
+    struct stat file_info;
+
+    if (fstat(fd, &file_info) < 0 || file_info.st_size == 0) {
+        close(fd);
+        throw std::runtime_error("Failed to read file " + path);
+    }
+
+    void* mapping = mmap(nullptr, file_info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+    // The mapping stays valid after the file is closed
+    close(fd);
+
+    if (mapping == MAP_FAILED) {
+        throw std::runtime_error("Failed to map file " + path);
+    }
+
+    data = static_cast<const uint8_t*>(mapping);
+    size = file_info.st_size;
+}
+
+MappedFile::~MappedFile() {
+    munmap(const_cast<uint8_t*>(data), size);
+}
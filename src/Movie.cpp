@@ -0,0 +1,51 @@
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+#include "Movie.h"
+
+Movie::Movie(const std::string& movie_file_name) {
+    std::ifstream movie_file(movie_file_name);
+
+    if (!movie_file.is_open()) {
+        throw std::runtime_error("Failed to open movie " + movie_file_name);
+    }
+
+    std::string line;
+
+    while (std::getline(movie_file, line)) {
+        // Header lines ("version 3", "romFilename ...") don't start with '|'
+        if (line.empty() || line[0] != '|') {
+            continue;
+        }
+
+        // Fields: |commands|port 0|port 1|expansion port|
+        std::vector<std::string> fields;
+        std::stringstream line_stream(line.substr(1));
+        std::string field;
+
+        while (std::getline(line_stream, field, '|')) {
+            fields.push_back(field);
+        }
+
+        port1_inputs.push_back(fields.size() > 1 ? parse_fm2_buttons(fields.at(1)) : 0);
+        port2_inputs.push_back(fields.size() > 2 ? parse_fm2_buttons(fields.at(2)) : 0);
+    }
+}
+
+size_t Movie::num_frames() const {
+    return port1_inputs.size();
+}
+
+uint8_t Movie::parse_fm2_buttons(const std::string& field) {
+    uint8_t buttons = 0;
+
+    // Characters are listed from the highest bit (Right) down to the lowest bit (A)
+    for (size_t i = 0; i < field.size() && i < 8; i++) {
+        if (field[i] != '.' && field[i] != ' ') {
+            buttons |= 1 << (7 - i);
+        }
+    }
+
+    return buttons;
+}
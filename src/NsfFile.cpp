@@ -0,0 +1,113 @@
+#include <algorithm>
+#include <stdexcept>
+
+#include "INESHeader.h"
+#include "NsfFile.h"
+
+static uint16_t read_u16(const uint8_t* data) {
+    return data[0] | (data[1] << 8);
+}
+
+// Header strings are 32 bytes, and only null terminated if they are shorter than that
+static std::string read_string(const uint8_t* data) {
+    const size_t MAX_LENGTH = 32;
+    return std::string(reinterpret_cast<const char*>(data), std::find(data, data + MAX_LENGTH, 0) - data);
+}
+
+NsfFile::NsfFile(const uint8_t* data, size_t size) {
+    if (size < HEADER_SIZE || data[0] != 'N' || data[1] != 'E' || data[2] != 'S' || data[3] != 'M' || data[4] != 0x1A) {
+        throw std::runtime_error("File is not in the NSF format");
+    }
+
+    version = data[0x05];
+    num_songs = data[0x06];
+    starting_song = data[0x07] > 0 ? data[0x07] - 1 : 0;
+
+    load_address = read_u16(data + 0x08);
+    init_address = read_u16(data + 0x0A);
+    play_address = read_u16(data + 0x0C);
+
+    name = read_string(data + 0x0E);
+    artist = read_string(data + 0x2E);
+    copyright = read_string(data + 0x4E);
+
+    // Some files leave the rate at 0, and mean the usual 60.1 Hz
+    ntsc_play_period_us = read_u16(data + 0x6E);
+
+    if (ntsc_play_period_us == 0) {
+        ntsc_play_period_us = 16639;
+    }
+
+    is_bank_switched = std::any_of(data + 0x70, data + 0x78, [](uint8_t bank) { return bank != 0; });
+
+    if (is_bank_switched) {
+        std::copy(data + 0x70, data + 0x78, initial_banks);
+    }
+
+    // Bit 0: PAL, bit 1: works on both
+    if ((data[0x7A] & 0x3) == 0x1) {
+        throw std::runtime_error("PAL-only NSF files are not supported");
+    }
+
+    if (data[0x7B] != 0) {
+        throw std::runtime_error("NSF expansion audio is not supported");
+    }
+
+    if (num_songs == 0) {
+        throw std::runtime_error("NSF file has no songs");
+    }
+
+    if (load_address < 0x8000) {
+        throw std::runtime_error("NSF files which load below 0x8000 are not supported");
+    }
+
+    // NSF2 files can follow the program with metadata, in which case the header gives the program's length
+    size_t data_size = size - HEADER_SIZE;
+    uint32_t program_length = data[0x7D] | (data[0x7E] << 8) | (data[0x7F] << 16);
+
+    if (version >= 2 && program_length > 0) {
+        data_size = std::min<size_t>(data_size, program_length);
+    }
+
+    const uint8_t* program = data + HEADER_SIZE;
+
+    if (is_bank_switched) {
+        size_t padding = load_address % BANK_SIZE;
+        size_t num_banks = (padding + data_size + BANK_SIZE - 1) / BANK_SIZE;
+
+        prg.assign(num_banks * BANK_SIZE, 0);
+        std::copy(program, program + data_size, prg.begin() + padding);
+    } else {
+        // Anything past 0xFFFF is cut off
+        size_t offset = load_address - 0x8000;
+        data_size = std::min(data_size, 0x8000 - offset);
+
+        prg.assign(0x8000, 0);
+        std::copy(program, program + data_size, prg.begin() + offset);
+    }
+}
+
+std::vector<uint8_t> NsfFile::build_ines_image() const {
+    size_t num_prg_units = (prg.size() + INESHeader::PRG_ROM_UNIT - 1) / INESHeader::PRG_ROM_UNIT;
+
+    if (num_prg_units > 0xFF) {
+        throw std::runtime_error("NSF program is too large");
+    }
+
+    std::vector<uint8_t> image(INESHeader::SIZE + num_prg_units * INESHeader::PRG_ROM_UNIT, 0);
+
+    const uint8_t MAPPER = 31;
+
+    image[0] = 'N';
+    image[1] = 'E';
+    image[2] = 'S';
+    image[3] = 0x1A;
+    image[4] = num_prg_units;
+    image[5] = 0;                       // CHR RAM, 8 KB by default
+    image[6] = (MAPPER & 0x0F) << 4;
+    image[7] = MAPPER & 0xF0;           // Bytes 8 - 15 stay 0, which gives the default 8 KB of PRG RAM
+
+    std::copy(prg.begin(), prg.end(), image.begin() + INESHeader::SIZE);
+
+    return image;
+}
@@ -0,0 +1,126 @@
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#include "MappedFile.h"
+#include "NsfPlayer.h"
+#include "mappers/Mapper031.h"
+
+NsfPlayer::NsfPlayer(const std::string& file_name) {
+    MappedFile file("roms/" + file_name);
+    load(file.data, file.size);
+}
+
+NsfPlayer::NsfPlayer(const uint8_t* data, size_t size) {
+    load(data, size);
+}
+
+void NsfPlayer::load(const uint8_t* data, size_t size) {
+    nsf = NsfFile(data, size);
+
+    std::vector<uint8_t> image = nsf.build_ines_image();
+    cartridge = std::make_unique<Cartridge>(image.data(), image.size());
+
+    nes.insert_cartridge(cartridge.get());
+    nes.reset();
+
+    play_period_cycles = nsf.ntsc_play_period_us * APU::CPU_CLOCK_RATE / 1000000.0;
+}
+
+void NsfPlayer::start_song(uint8_t song) {
+    if (song >= nsf.num_songs) {
+        throw std::runtime_error("NSF file has no song " + std::to_string(song + 1) + ", it has " + std::to_string(nsf.num_songs));
+    }
+
+    std::fill(nes.cpu_RAM.begin(), nes.cpu_RAM.end(), 0);
+
+    CowBuffer& prg_ram = cartridge->mapper->PRG_RAM;
+    std::fill(prg_ram.mutable_data(), prg_ram.mutable_data() + prg_ram.size(), 0);
+
+    for (uint16_t address = 0x4000; address <= 0x4013; address++) {
+        nes.write_cpu(address, 0);
+    }
+
+    nes.write_cpu(0x4015, 0x0F);
+
+    // No frame counter IRQs
+    nes.write_cpu(0x4017, 0x40);
+
+    for (uint16_t window = 0; window < 8; window++) {
+        nes.write_cpu(Mapper031::BANK_REGISTER_START + window, nsf.initial_banks[window]);
+    }
+
+    nes.cpu->reset();
+    nes.cpu->reset_IRQ();
+    nes.cpu_stall_cycles = 0;
+
+    // INIT takes the song in A, and 0 in X for NTSC
+    nes.cpu->A = song;
+    nes.cpu->X = 0;
+    nes.cpu->Y = 0;
+
+    call_routine(nsf.init_address);
+
+    uint64_t deadline = nes.num_cpu_cycles + INIT_TIMEOUT_CYCLES;
+
+    while (!has_routine_returned()) {
+        if (nes.num_cpu_cycles >= deadline) {
+            throw std::runtime_error("NSF INIT routine did not return");
+        }
+
+        nes.tick_cpu();
+    }
+
+    is_routine_running = false;
+    next_play_cycle = static_cast<double>(nes.num_cpu_cycles);
+}
+
+void NsfPlayer::call_routine(uint16_t address) {
+    // RTS returns to the pushed address plus one
+    nes.cpu->stack_push(static_cast<uint16_t>(RETURN_ADDRESS - 1));
+    nes.cpu->program_counter = address;
+    is_routine_running = true;
+}
+
+bool NsfPlayer::has_routine_returned() const {
+    // The CPU runs a whole instruction on its first cycle, so wait for the RTS's cycles to pass too
+    return nes.cpu->program_counter == RETURN_ADDRESS && nes.cpu->clock_cycles_remaining == 0;
+}
+
+void NsfPlayer::run_until(uint64_t target_cycle) {
+    while (nes.num_cpu_cycles < target_cycle) {
+        if (is_routine_running && has_routine_returned()) {
+            is_routine_running = false;
+        }
+
+        if (nes.num_cpu_cycles >= next_play_cycle) {
+            next_play_cycle += play_period_cycles;
+
+            if (is_routine_running) {
+                num_skipped_play_calls++;
+            } else {
+                call_routine(nsf.play_address);
+                num_play_calls++;
+            }
+        }
+
+        if (is_routine_running) {
+            nes.tick_cpu();
+            continue;
+        }
+
+        // Nothing runs until the next PLAY call, so skip to it. The APU only has to step through its own events
+        nes.num_cpu_cycles = std::min(target_cycle, static_cast<uint64_t>(std::ceil(next_play_cycle)));
+
+        if (nes.num_cpu_cycles >= nes.apu->next_event_cycle) {
+            nes.apu->run_until(nes.num_cpu_cycles);
+        }
+
+        // DMC fetches while the CPU was idle have nothing to stall
+        nes.cpu_stall_cycles = 0;
+    }
+}
+
+void NsfPlayer::run_seconds(double seconds) {
+    run_until(nes.num_cpu_cycles + static_cast<uint64_t>(seconds * APU::CPU_CLOCK_RATE));
+}
@@ -1,15 +1,12 @@
 
 #include "PPU.h"
+#include <cstring>
 #include <iostream>
 
 using namespace std;
 
 PPU::PPU() {
-    ui = new UI();
-}
 
-PPU::PPU(bool ui_disabled) {
-    ui = new UI(ui_disabled);
 }
 
 uint8_t PPU::get_sprite_height() const {
@@ -216,22 +213,12 @@ void PPU::write_from_cpu(uint16_t address, uint8_t val) {
 // Communicate with PPU bus
 
 uint8_t PPU::read_from_ppu(uint16_t address) {
-    if (cartridge->read_ppu(address)) {
-        // should handle the pattern table cases (addresses 0x0000 - 0x1FFF)
-
-        if (cartridge->CHR_ROM.size() == 0) {
-            return VRAM.at(address);
-        }
-
-        return cartridge->CHR_ROM.at(address);
-    } else if (address >= 0x2000 && address <= 0x2FFF) {
+    if (address <= 0x1FFF) {
+        // Pattern tables, through the cartridge's CHR page table
+        return cartridge->read_ppu(address);
+    } else if (address >= 0x2000 && address <= 0x3EFF) {
         // handle nametables and mirroring
-        address = map_to_nametable(address);
-        return VRAM.at(address);
-    } else if (address >= 0x3000 && address <= 0x3EFF) {
-        // mirror of 0x2000 - 0x2EFF
-        address = map_to_nametable(address - 0x1000);
-        return VRAM.at(address);
+        return VRAM.data()[map_to_nametable(address)];
     } else if (address >= 0x3F00 && address <= 0x3F1F) {
         // palette table
         // 0x3F00 - 0x3F1F is mirrored in the range 0x3F20 - 0x3FFF
@@ -242,48 +229,18 @@ uint8_t PPU::read_from_ppu(uint16_t address) {
 }
 
 uint16_t PPU::map_to_nametable(uint16_t address) {
-    if (address < 0x2000 || address > 0x3000) {
-        throw std::runtime_error("Attempted to access nametable out of bounds at address " + std::to_string(address));
-    }
-
-    switch (cartridge->mirroring_type) {
-        case (HORIZONTAL):
-            if (address >= 0x2400 && address <= 0x27FF) {
-                address -= 0x400;
-            } else if (address >= 0x2C00 && address <= 0x2FFF) {
-                address -= 0x400;
-            }
-            break;
-        case (VERTICAL):
-            if (address >= 0x2800 && address <= 0x2BFF) {
-                address -= 0x800;
-            } else if (address >= 0x2C00 && address <= 0x2FFF) {
-                address -= 0x800;
-            }
-            break;
-        case (FOUR_SCREEN):
-            throw std::runtime_error("Four screen mirroring is unsupported");
-            break;
-        default:
-            throw std::runtime_error("Unknown mirroring type on cartridge");
-            break;
-    }
-
-    return address;
+    // 0x3000 - 0x3EFF mirrors 0x2000 - 0x2EFF, so only bits 10 - 11 pick the nametable
+    return cartridge->nametable_pages[(address >> 10) & 0x3] + (address & 0x3FF);
 }
 
 void PPU::write_from_ppu(uint16_t address, uint8_t val) {
 
-    if (cartridge->write_ppu(address, val)) {
-        // In this case, we only write if we're working with CHR-RAM instead of CHR-ROM, because CHR-ROM is unwriteable
-        VRAM.at(address) = val;
-    } else if (address >= 0x2000 && address <= 0x2FFF) {
+    if (address <= 0x1FFF) {
+        // Pattern tables. Only CHR RAM can be written
+        cartridge->write_ppu(address, val);
+    } else if (address >= 0x2000 && address <= 0x3EFF) {
         // handle nametables and mirroring
-        address = map_to_nametable(address);
-        VRAM.at(address) = val;
-    } else if (address >= 0x3000 && address <= 0x3EFF) {
-        // mirror of 0x2000 - 0x2EFF
-        write_from_ppu(address & 0x2EFF, val);
+        VRAM.set(map_to_nametable(address), val);
     } else if (address >= 0x3F00 && address <= 0x3FFF) {
         // palette table
         // 0x3F00 - 0x3F1F is mirrored in the range 0x3F20 - 0x3FFF
@@ -310,7 +267,18 @@ void PPU::load_OAMDMA(uint8_t high_byte) {
     // Copy over page of data to OAMDMA starting at oamaddr, wrapping around in case the address is greater than 255
 
     uint16_t starting_address = (high_byte) << 8;
+    const uint8_t* source = bus->direct_page(high_byte);
+
+    // RAM and ROM pages can be copied in bulk, in at most two pieces since OAM wraps around at oamaddr
+    if (source != nullptr) {
+        size_t first_part = PRIMARY_OAM_SIZE - oamaddr;
+
+        std::memcpy(primary_OAM.data() + oamaddr, source, first_part);
+        std::memcpy(primary_OAM.data(), source + first_part, oamaddr);
+        return;
+    }
 
+    // Other pages can have side effects on read (PPU and APU registers), so read them one byte at a time
     for (int i = 0; i < 256; i++) {
         uint8_t destination_address = oamaddr + i;
         uint16_t source_address = starting_address | i;
@@ -526,10 +494,42 @@ void PPU::run_sprite_evaluation() {
     }
 }
 
+void PPU::report_pattern_fetch() {
+    // One pattern fetch per 8 dot fetch cycle: background tiles on dots 1 - 256 and 321 - 336, sprites on dots 257 - 320
+    if (cur_dot % 8 != 5 || cur_dot > 333) {
+        return;
+    }
+
+    uint16_t address;
+
+    if (cur_dot >= 261 && cur_dot <= 317) {
+        if (get_sprite_height() == 16) {
+            // The pattern table comes from the tile number. Empty slots fetch tile 0xFF, from 0x1000
+            address = (OAM_buffer[4 * ((cur_dot - 261) / 8) + 1] & 1) ? 0x1000 : 0;
+        } else {
+            address = ppuctrl.sprite_tile_select ? 0x1000 : 0;
+        }
+    } else {
+        address = ppuctrl.background_tile_select ? 0x1000 : 0;
+    }
+
+    Mapper* mapper = cartridge->mapper;
+    mapper->notify_pattern_fetch(address, bus->num_ticks);
+
+    // The mapper holds the IRQ line until it is acknowledged
+    if (mapper->irq_pending) {
+        bus->cpu->assert_IRQ(IRQ_MAPPER);
+    }
+}
+
 void PPU::tick() {
 
     run_sprite_evaluation();
 
+    if (cartridge->mapper->watches_ppu_a12 && is_rendering_enabled() && (cur_ppu_rendering_stage == VISIBLE || cur_ppu_rendering_stage == PRE_RENDER)) {
+        report_pattern_fetch();
+    }
+
     switch (cur_ppu_rendering_stage) {
         case PRE_RENDER:
             {
@@ -590,7 +590,7 @@ void PPU::tick() {
                     oamaddr = 0;
                 }
 
-                if (cur_dot >= 1 && cur_dot <= 256) {
+                if (cur_dot >= 1 && cur_dot <= 256 && (!is_skipping_frame || is_pixel_needed_when_skipping())) {
 
                     // Start background rendering
                     
@@ -677,9 +677,9 @@ void PPU::tick() {
     
                     uint8_t background_pixel_color = (is_bit_set(tile_offset_x, background_pixel_layer_1) << 1) | is_bit_set(tile_offset_x, background_pixel_layer_0);
     
-                    if (((coarse_x & 0x3) == 0) || ((coarse_x & 0x2) == 0x2)) {
-                        ui->set_background_palette(background_color0, background_color1, background_color2, background_color3);
-                    }
+                    // Set for every pixel: a scanline can start on any tile, so the palette left over from the last pixel drawn
+                    // may belong to a different attribute quadrant, or (after skipped frames) a different frame
+                    screen.set_background_palette(background_color0, background_color1, background_color2, background_color3);
 
 
                     // Start sprite rendering from secondary OAM
@@ -689,7 +689,10 @@ void PPU::tick() {
                     bool is_sprite_here = false;
                     bool is_sprite_0_rendered = false;
 
-                    vector<Sprite> sprite_priority_order;
+                    // At most 8 sprites are on a scanline, so this never needs to grow.
+                    // A fixed array keeps the per-pixel path off the heap, which matters when many instances run in parallel.
+                    Sprite sprite_priority_order[SECONDARY_OAM_SIZE / 4];
+                    unsigned int num_sprites_here = 0;
 
                     for (unsigned int i = 0; i < OAM_buffer.size(); i += 4) {
                         Sprite cur_sprite = Sprite(
@@ -700,7 +703,7 @@ void PPU::tick() {
                         );
 
                         if (cur_sprite.x_position <= pixel_x && cur_sprite.x_position + 7 >= pixel_x) {
-                            sprite_priority_order.push_back(cur_sprite);
+                            sprite_priority_order[num_sprites_here++] = cur_sprite;
                             is_sprite_here = true;
 
                             if (OAM_indices.at(i / 4) == 0) {
@@ -713,8 +716,8 @@ void PPU::tick() {
 
                     uint8_t sprite_pixel_color;
 
-                    while (cur_sprite_index < sprite_priority_order.size()) {
-                        Sprite sprite_to_render = sprite_priority_order.at(cur_sprite_index);
+                    while (cur_sprite_index < num_sprites_here) {
+                        Sprite sprite_to_render = sprite_priority_order[cur_sprite_index];
 
                         // Get sprite offset from top, left
                         uint8_t sprite_offset_x = pixel_x - sprite_to_render.x_position;
@@ -739,7 +742,7 @@ void PPU::tick() {
                         uint8_t sprite_color2 = read_from_ppu(sprite_palette_index + 2);
                         uint8_t sprite_color3 = read_from_ppu(sprite_palette_index + 3);
         
-                        ui->set_sprite_palette(sprite_color0, sprite_color1, sprite_color2, sprite_color3);
+                        screen.set_sprite_palette(sprite_color0, sprite_color1, sprite_color2, sprite_color3);
     
                         uint16_t sprite_pattern_table_address;
     
@@ -798,8 +801,8 @@ void PPU::tick() {
 
                     Sprite sprite_to_render;
 
-                    if (cur_sprite_index < sprite_priority_order.size()) {
-                        sprite_to_render = sprite_priority_order.at(cur_sprite_index);
+                    if (cur_sprite_index < num_sprites_here) {
+                        sprite_to_render = sprite_priority_order[cur_sprite_index];
                     } else {
                         is_sprite_here = false;
                     }
@@ -820,14 +823,14 @@ void PPU::tick() {
                     bool is_sprite_rendered = !is_sprite_left_clipped && ppumask.sprite_enable && scanline > 0 && is_sprite_here && ((sprite_pixel_color != 0 && is_sprite_in_front) || (background_pixel_color == 0));
                     
                     if (is_sprite_rendered) {
-                        ui->set_pixel(pixel_y, pixel_x, sprite_pixel_color, false);
+                        screen.set_pixel(pixel_y, pixel_x, sprite_pixel_color, false);
                     } else if (is_background_rendered) {
-                        ui->set_pixel(pixel_y, pixel_x, background_pixel_color, true);
+                        screen.set_pixel(pixel_y, pixel_x, background_pixel_color, true);
                     } else {
                         // If both background and sprite are transparent, set the pixel to the background color
                         // This is at mem. address 0x3F00 or 0x3F10 in PPU memory
                         // Which is index 0 or 16 in PALETTE_RAM
-                        ui->set_pixel_color(pixel_y, pixel_x, PALETTE_RAM.at(0));
+                        screen.set_pixel_color(pixel_y, pixel_x, PALETTE_RAM.at(0));
                     }
 
                 }
@@ -914,8 +917,11 @@ void PPU::tick() {
 
                     cur_ppu_rendering_stage = PRE_RENDER;
 
-                    ui->tick();
+                    if (video_output != nullptr && !is_skipping_frame) {
+                        video_output->present_frame(screen);
+                    }
                     frames_elapsed++;
+                    update_frame_skipping();
                 } else {
                     cur_dot++;
 
@@ -944,4 +950,118 @@ void PPU::reset() {
 
 void PPU::attach_bus(Bus* b) {
     bus = b;
-}
\ No newline at end of file
+}
+
+void PPU::attach_video_output(VideoOutput* output) {
+    video_output = output;
+}
+
+void PPU::set_frame_skip(uint32_t new_frame_skip) {
+    frame_skip = new_frame_skip;
+    update_frame_skipping();
+}
+
+void PPU::update_frame_skipping() {
+    is_skipping_frame = frame_skip > 0 && frames_elapsed % (frame_skip + 1) != 0;
+}
+
+bool PPU::is_pixel_needed_when_skipping() const {
+    uint16_t pixel_x = cur_dot - 1;
+
+    // The same conditions the pixel itself checks before a hit, less the ones which need the pixel's colors.
+    // Only the first hit in a frame changes anything
+    if (ppustatus.sprite_hit || !ppumask.background_enable || !ppumask.sprite_enable || pixel_x == 255 || scanline >= 239) {
+        return false;
+    }
+
+    for (unsigned int i = 0; i < OAM_buffer.size(); i += 4) {
+        uint8_t x_position = OAM_buffer[i + 3];
+
+        if (OAM_indices[i / 4] == 0 && x_position <= pixel_x && x_position + 7 >= pixel_x) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void PPU::save_state(StateWriter& state) const {
+    state.write_buffer(VRAM.data(), VRAM.size());
+    state.write_vector(PALETTE_RAM);
+    state.write_vector(primary_OAM);
+    state.write_vector(secondary_OAM);
+    state.write_vector(OAM_indices);
+    state.write_vector(OAM_buffer);
+
+    state.write(scanline);
+    state.write(cur_dot);
+    state.write(v);
+    state.write(t);
+    state.write(fine_x_offset);
+    state.write(open_bus_val);
+    state.write(w);
+
+    state.write(ppuctrl);
+    state.write(ppumask);
+    state.write(ppustatus);
+    state.write(oamaddr);
+    state.write(oamdata);
+    state.write(ppuaddr);
+
+    state.write(ppustatus_vblank_read_race_condition);
+    state.write(has_nmi_triggered);
+    state.write(ppudata_read_buffer);
+    state.write(frames_elapsed);
+
+    state.write(cur_sprite_evaluation_stage);
+    state.write(num_sprites_found);
+    state.write(cur_ppu_rendering_stage);
+
+    // The picture is hashed on its own, so runs which draw differently (skipping frames, say) can still agree on the state
+    if (state.is_hashing()) {
+        return;
+    }
+
+    state.write_vector(screen.pixels);
+    state.write(screen.cur_background_palette);
+    state.write(screen.cur_sprite_palette);
+}
+
+void PPU::load_state(StateReader& state) {
+    state.read_buffer(VRAM.mutable_data(), VRAM.size());
+    state.read_vector(PALETTE_RAM);
+    state.read_vector(primary_OAM);
+    state.read_vector(secondary_OAM);
+    state.read_vector(OAM_indices);
+    state.read_vector(OAM_buffer);
+
+    state.read(scanline);
+    state.read(cur_dot);
+    state.read(v);
+    state.read(t);
+    state.read(fine_x_offset);
+    state.read(open_bus_val);
+    state.read(w);
+
+    state.read(ppuctrl);
+    state.read(ppumask);
+    state.read(ppustatus);
+    state.read(oamaddr);
+    state.read(oamdata);
+    state.read(ppuaddr);
+
+    state.read(ppustatus_vblank_read_race_condition);
+    state.read(has_nmi_triggered);
+    state.read(ppudata_read_buffer);
+    state.read(frames_elapsed);
+
+    state.read(cur_sprite_evaluation_stage);
+    state.read(num_sprites_found);
+    state.read(cur_ppu_rendering_stage);
+
+    state.read_vector(screen.pixels);
+    state.read(screen.cur_background_palette);
+    state.read(screen.cur_sprite_palette);
+
+    update_frame_skipping();
+}
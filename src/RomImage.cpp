@@ -0,0 +1,77 @@
+#include <cstring>
+#include <mutex>
+#include <unordered_map>
+
+#include "RomImage.h"
+#include "Helpers.h"
+
+// Every image that is alive, keyed by content hash
+static std::mutex registry_lock;
+static std::unordered_map<uint64_t, std::weak_ptr<const RomImage>> registry;
+
+static bool has_contents(const RomImage& image, const uint8_t* prg_rom, size_t prg_rom_size, const uint8_t* chr_rom, size_t chr_rom_size) {
+    return image.PRG_ROM.size() == prg_rom_size && image.CHR_ROM.size() == chr_rom_size &&
+        (prg_rom_size == 0 || std::memcmp(image.PRG_ROM.data(), prg_rom, prg_rom_size) == 0) &&
+        (chr_rom_size == 0 || std::memcmp(image.CHR_ROM.data(), chr_rom, chr_rom_size) == 0);
+}
+
+std::shared_ptr<const RomImage> RomImage::load(const uint8_t* prg_rom, size_t prg_rom_size, const uint8_t* chr_rom, size_t chr_rom_size,
+                                               std::shared_ptr<const MappedFile> mapping) {
+    uint64_t content_hash = hash_bytes(chr_rom, chr_rom_size, hash_bytes(prg_rom, prg_rom_size));
+
+    std::lock_guard<std::mutex> guard(registry_lock);
+
+    std::weak_ptr<const RomImage>& entry = registry[content_hash];
+    std::shared_ptr<const RomImage> existing = entry.lock();
+
+    if (existing != nullptr) {
+        // A hash collision gets its own unshared image rather than the wrong ROM
+        if (has_contents(*existing, prg_rom, prg_rom_size, chr_rom, chr_rom_size)) {
+            return existing;
+        }
+    }
+
+    std::shared_ptr<RomImage> image = std::make_shared<RomImage>();
+
+    if (mapping != nullptr) {
+        image->mapping = mapping;
+    } else {
+        image->storage.assign(prg_rom, prg_rom + prg_rom_size);
+        image->storage.insert(image->storage.end(), chr_rom, chr_rom + chr_rom_size);
+        prg_rom = image->storage.data();
+        chr_rom = image->storage.data() + prg_rom_size;
+    }
+
+    image->PRG_ROM = ByteView{prg_rom, prg_rom_size};
+    image->CHR_ROM = ByteView{chr_rom, chr_rom_size};
+    image->content_hash = content_hash;
+
+    if (existing == nullptr) {
+        entry = image;
+    }
+
+    // Drop entries for images which have been freed, so the registry doesn't grow with every ROM ever loaded
+    for (auto it = registry.begin(); it != registry.end();) {
+        if (it->second.expired() && it->first != content_hash) {
+            it = registry.erase(it);
+        } else {
+            it++;
+        }
+    }
+
+    return image;
+}
+
+size_t RomImage::num_loaded() {
+    std::lock_guard<std::mutex> guard(registry_lock);
+
+    size_t count = 0;
+
+    for (auto& entry : registry) {
+        if (!entry.second.expired()) {
+            count++;
+        }
+    }
+
+    return count;
+}
@@ -0,0 +1,69 @@
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "SaveFile.h"
+
+constexpr std::chrono::milliseconds SaveFile::FLUSH_INTERVAL;
+
+SaveFile::SaveFile(const std::string& path, size_t file_size) {
+    if (file_size == 0) {
+        throw std::runtime_error("Save file " + path + " would be empty");
+    }
+
+    int fd = open(path.c_str(), O_RDWR | O_CREAT, 0644);
+
+    if (fd < 0) {
+        throw std::runtime_error("Failed to open save file " + path);
+    }
+
+    struct stat file_info;
+
+    // New files are zero filled by ftruncate
+    if (fstat(fd, &file_info) < 0 || (static_cast<size_t>(file_info.st_size) != file_size && ftruncate(fd, file_size) < 0)) {
+        close(fd);
+        throw std::runtime_error("Failed to resize save file " + path);
+    }
+
+    void* mapping = mmap(nullptr, file_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+    // The mapping stays valid after the file is closed
+    close(fd);
+
+    if (mapping == MAP_FAILED) {
+        throw std::runtime_error("Failed to map save file " + path);
+    }
+
+    data = static_cast<uint8_t*>(mapping);
+    size = file_size;
+
+    flusher = std::thread(&SaveFile::run_flusher, this);
+}
+
+SaveFile::~SaveFile() {
+    {
+        std::lock_guard<std::mutex> guard(flusher_lock);
+        stopping = true;
+    }
+
+    flusher_wake.notify_one();
+    flusher.join();
+
+    msync(data, size, MS_SYNC);
+    munmap(data, size);
+}
+
+void SaveFile::flush() {
+    msync(data, size, MS_ASYNC);
+}
+
+void SaveFile::run_flusher() {
+    std::unique_lock<std::mutex> guard(flusher_lock);
+
+    while (!flusher_wake.wait_for(guard, FLUSH_INTERVAL, [this] { return stopping; })) {
+        flush();
+    }
+}
@@ -0,0 +1,82 @@
+#include <stdexcept>
+#include <string>
+
+#include "Screen.h"
+
+const uint32_t Screen::COLORS[PALETTE_SIZE] = {
+    0x626262FF, 0x002C7CFF, 0x11159CFF, 0x36039CFF, 0x55007CFF, 0x670044FF, 0x670703FF, 0x551C00FF, 0x363200FF, 0x114400FF, 0x004E00FF, 0x004C03FF, 0x004044FF, 0x000000FF, 0x000000FF, 0x000000FF,
+    0xABABABFF, 0x1260CEFF, 0x3D42FAFF, 0x6E29FAFF, 0x991CCEFF, 0xB11E81FF, 0xB12F29FF, 0x994A00FF, 0x6E6900FF, 0x3D8200FF, 0x128F00FF, 0x008D29FF, 0x007C81FF, 0x000000FF, 0x000000FF, 0x000000FF,
+    0xFFFFFFFF, 0x60B2FFFF, 0x8D92FFFF, 0xC078FFFF, 0xEC6AFFFF, 0xFF6DD4FF, 0xFF7F79FF, 0xEC9B2AFF, 0xC0BA00FF, 0x8DD400FF, 0x60E22AFF, 0x47E079FF, 0x47CED4FF, 0x4E4E4EFF, 0X000000FF, 0x000000FF,
+    0XFFFFFFFF, 0XBFE0FFFF, 0XD1D3FFFF, 0XE6C9FFFF, 0XF7C3FFFF, 0XFFC4EEFF, 0XFFCBC9FF, 0XF7D7A9FF, 0XE6E397FF, 0XD1EE97FF, 0XBFF3A9FF, 0XB5F2C9FF, 0xB5EBEEFF, 0xB8B8B8FF, 0x000000FF, 0x000000FF 
+};
+
+void Screen::set_pixel(uint16_t row, uint16_t col, uint8_t color_index, bool using_background_palette) {
+    if (col >= SCREEN_WIDTH || row >= SCREEN_HEIGHT) {
+        throw std::runtime_error("Attempted to draw pixel out of bounds at position " + std::to_string(col) + ", " + std::to_string(row));
+    }
+
+    if (color_index > 3) {
+        throw std::runtime_error("Unknown pixel index color " + std::to_string(color_index));
+    }
+
+    if (using_background_palette) {
+        pixels[row * SCREEN_WIDTH + col] = cur_background_palette[color_index];
+    } else {
+        pixels[row * SCREEN_WIDTH + col] = cur_sprite_palette[color_index];
+    }
+}
+
+void Screen::set_pixel_color(uint16_t row, uint16_t col, uint8_t color_index) {
+    if (col >= SCREEN_WIDTH || row >= SCREEN_HEIGHT) {
+        throw std::runtime_error("Attempted to draw pixel out of bounds at position " + std::to_string(col) + ", " + std::to_string(row));
+    }
+
+    // Palette RAM entries are 6 bits wide
+    pixels[row * SCREEN_WIDTH + col] = color_index & 0x3F;
+}
+
+void Screen::set_background_palette(uint8_t color0, uint8_t color1, uint8_t color2, uint8_t color3) {
+    if (color0 >= PALETTE_SIZE) {
+        throw std::runtime_error("color0 is " + std::to_string(color0) + ", which is out of bounds of the palette size");
+    }
+
+    if (color1 >= PALETTE_SIZE) {
+        throw std::runtime_error("color1 is " + std::to_string(color1) + ", which is out of bounds of the palette size");
+    }
+
+    if (color2 >= PALETTE_SIZE) {
+        throw std::runtime_error("color2 is " + std::to_string(color2) + ", which is out of bounds of the palette size");
+    }
+
+    if (color3 >= PALETTE_SIZE) {
+        throw std::runtime_error("color3 is " + std::to_string(color3) + ", which is out of bounds of the palette size");
+    }
+
+    cur_background_palette[0] = color0;
+    cur_background_palette[1] = color1;
+    cur_background_palette[2] = color2;
+    cur_background_palette[3] = color3;
+}
+
+void Screen::set_sprite_palette(uint8_t color0, uint8_t color1, uint8_t color2, uint8_t color3) {
+    if (color0 >= PALETTE_SIZE) {
+        throw std::runtime_error("color0 is " + std::to_string(color0) + ", which is out of bounds of the palette size");
+    }
+
+    if (color1 >= PALETTE_SIZE) {
+        throw std::runtime_error("color1 is " + std::to_string(color1) + ", which is out of bounds of the palette size");
+    }
+
+    if (color2 >= PALETTE_SIZE) {
+        throw std::runtime_error("color2 is " + std::to_string(color2) + ", which is out of bounds of the palette size");
+    }
+
+    if (color3 >= PALETTE_SIZE) {
+        throw std::runtime_error("color3 is " + std::to_string(color3) + ", which is out of bounds of the palette size");
+    }
+
+    cur_sprite_palette[0] = color0;
+    cur_sprite_palette[1] = color1;
+    cur_sprite_palette[2] = color2;
+    cur_sprite_palette[3] = color3;
+}
@@ -0,0 +1,126 @@
+#include <algorithm>
+
+#include "ThreadPool.h"
+
+ThreadPool::ThreadPool(unsigned num_threads) {
+    if (num_threads == 0) {
+        num_threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    for (unsigned i = 0; i < num_threads; i++) {
+        queues.push_back(std::make_unique<WorkQueue>());
+    }
+
+    for (unsigned i = 0; i < num_threads; i++) {
+        workers.emplace_back(&ThreadPool::run_worker, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> guard(sleep_lock);
+        stopping = true;
+    }
+
+    work_available.notify_all();
+
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+}
+
+size_t ThreadPool::size() const {
+    return workers.size();
+}
+
+void ThreadPool::submit(std::function<void()> task) {
+    WorkQueue& queue = *queues.at(next_queue++ % queues.size());
+
+    num_unfinished_tasks++;
+
+    {
+        std::lock_guard<std::mutex> guard(queue.lock);
+        queue.tasks.push_back(std::move(task));
+    }
+
+    // Take the sleep lock so a worker can't miss the wakeup between checking for work and going to sleep
+    {
+        std::lock_guard<std::mutex> guard(sleep_lock);
+    }
+
+    work_available.notify_one();
+}
+
+void ThreadPool::wait_idle() {
+    std::unique_lock<std::mutex> guard(sleep_lock);
+    all_tasks_done.wait(guard, [this] { return num_unfinished_tasks == 0; });
+}
+
+bool ThreadPool::take_task(size_t worker_index, std::function<void()>& task) {
+    // Newest task from our own queue first, it is the most likely to still be in cache
+    {
+        WorkQueue& own_queue = *queues.at(worker_index);
+        std::lock_guard<std::mutex> guard(own_queue.lock);
+
+        if (!own_queue.tasks.empty()) {
+            task = std::move(own_queue.tasks.back());
+            own_queue.tasks.pop_back();
+            return true;
+        }
+    }
+
+    // Steal the oldest task from another worker
+    for (size_t i = 1; i < queues.size(); i++) {
+        WorkQueue& victim = *queues.at((worker_index + i) % queues.size());
+        std::lock_guard<std::mutex> guard(victim.lock);
+
+        if (!victim.tasks.empty()) {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void ThreadPool::run_worker(size_t worker_index) {
+    std::function<void()> task;
+
+    while (true) {
+        if (take_task(worker_index, task)) {
+            task();
+            task = nullptr;
+
+            if (--num_unfinished_tasks == 0) {
+                std::lock_guard<std::mutex> guard(sleep_lock);
+                all_tasks_done.notify_all();
+            }
+
+            continue;
+        }
+
+        std::unique_lock<std::mutex> guard(sleep_lock);
+
+        if (stopping) {
+            return;
+        }
+
+        // Tasks may have been queued since we last looked. Only sleep if there is nothing left to run
+        work_available.wait(guard, [this] {
+            if (stopping) {
+                return true;
+            }
+
+            for (const std::unique_ptr<WorkQueue>& queue : queues) {
+                std::lock_guard<std::mutex> queue_guard(queue->lock);
+
+                if (!queue->tasks.empty()) {
+                    return true;
+                }
+            }
+
+            return false;
+        });
+    }
+}
@@ -0,0 +1,140 @@
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <exception>
+#include <mutex>
+
+#include "VecEnv.h"
+
+VecEnv::VecEnv(const uint8_t* rom_data, size_t rom_size, size_t num_envs, unsigned num_threads, uint64_t boot_frames, uint64_t max_episode_frames)
+    : pool(num_threads), max_episode_frames(max_episode_frames) {
+
+    if (num_envs == 0) {
+        throw std::runtime_error("VecEnv needs at least one instance");
+    }
+
+    for (size_t i = 0; i < num_envs; i++) {
+        std::unique_ptr<Instance> instance = std::make_unique<Instance>();
+
+        instance->cartridge = std::make_unique<Cartridge>(rom_data, rom_size);
+        instance->bus = std::make_unique<Bus>();
+        instance->bus->io->connect_controller(&instance->port1, 1);
+        instance->bus->io->connect_controller(&instance->port2, 2);
+        instance->bus->insert_cartridge(instance->cartridge.get());
+        instance->bus->reset();
+
+        instances.push_back(std::move(instance));
+    }
+
+    // Boot once, then share the result with every instance
+    Bus* first_bus = instances.at(0)->bus.get();
+
+    for (uint64_t i = 0; i < boot_frames; i++) {
+        first_bus->run_frame();
+    }
+
+    first_bus->save_state(reset_state);
+
+    observations.resize(num_envs * OBSERVATION_SIZE);
+    ram.resize(num_envs * RAM_SIZE);
+    dones.resize(num_envs);
+
+    reset_all();
+}
+
+size_t VecEnv::size() const {
+    return instances.size();
+}
+
+void VecEnv::write_observation(size_t index) {
+    Bus* bus = instances.at(index)->bus.get();
+
+    std::memcpy(observations.data() + index * OBSERVATION_SIZE, bus->ppu->screen.pixels.data(), OBSERVATION_SIZE);
+    std::memcpy(ram.data() + index * RAM_SIZE, bus->cpu_RAM.data(), RAM_SIZE);
+}
+
+void VecEnv::reset(size_t index) {
+    Instance& instance = *instances.at(index);
+
+    instance.bus->load_state(reset_state.data(), reset_state.size());
+    instance.episode_frames = 0;
+
+    write_observation(index);
+}
+
+void VecEnv::reset_all() {
+    for (size_t i = 0; i < instances.size(); i++) {
+        reset(i);
+    }
+}
+
+void VecEnv::step_range(size_t first, size_t last, const uint8_t* inputs) {
+    for (size_t i = first; i < last; i++) {
+        Instance& instance = *instances[i];
+
+        instance.port1.set_buttons(inputs[2 * i]);
+        instance.port2.set_buttons(inputs[2 * i + 1]);
+
+        instance.bus->run_frame();
+        instance.episode_frames++;
+
+        if (max_episode_frames > 0 && instance.episode_frames >= max_episode_frames) {
+            // The observation is the first frame of the new episode
+            dones[i] = 1;
+            reset(i);
+        } else {
+            dones[i] = 0;
+            write_observation(i);
+        }
+    }
+}
+
+void VecEnv::step(const uint8_t* inputs) {
+    auto start = std::chrono::steady_clock::now();
+
+    // One contiguous block of instances per worker keeps the number of tasks (and their overhead) small
+    size_t num_tasks = std::min(pool.size(), instances.size());
+    size_t block_size = (instances.size() + num_tasks - 1) / num_tasks;
+
+    std::mutex error_lock;
+    std::exception_ptr error;
+
+    for (size_t first = 0; first < instances.size(); first += block_size) {
+        size_t last = std::min(first + block_size, instances.size());
+
+        pool.submit([this, first, last, inputs, &error_lock, &error] {
+            try {
+                step_range(first, last, inputs);
+            } catch (...) {
+                std::lock_guard<std::mutex> guard(error_lock);
+                error = std::current_exception();
+            }
+        });
+    }
+
+    pool.wait_idle();
+
+    if (error) {
+        std::rethrow_exception(error);
+    }
+
+    last_step_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    total_step_seconds += last_step_seconds;
+    num_steps++;
+}
+
+double VecEnv::mean_step_latency_us() const {
+    if (num_steps == 0) {
+        return 0;
+    }
+
+    return 1e6 * total_step_seconds / num_steps;
+}
+
+double VecEnv::frames_per_second() const {
+    if (total_step_seconds == 0) {
+        return 0;
+    }
+
+    return num_steps * instances.size() / total_step_seconds;
+}
@@ -0,0 +1,125 @@
+#include <algorithm>
+#include <stdexcept>
+
+#include "WavWriter.h"
+
+constexpr std::chrono::milliseconds WavWriter::WRITER_INTERVAL;
+
+// WAV files are little endian whatever the host is
+static void put_u16(uint8_t* out, uint16_t value) {
+    out[0] = value & 0xFF;
+    out[1] = value >> 8;
+}
+
+static void put_u32(uint8_t* out, uint32_t value) {
+    put_u16(out, value & 0xFFFF);
+    put_u16(out + 2, value >> 16);
+}
+
+WavWriter::WavWriter(const std::string& file_path) : path(file_path) {
+    file = std::fopen(path.c_str(), "wb");
+
+    if (file == nullptr) {
+        throw std::runtime_error("Failed to open " + path + " for writing");
+    }
+
+    // Placeholder sizes, until close() knows them
+    write_header(0);
+
+    writer = std::thread(&WavWriter::run_writer, this);
+}
+
+WavWriter::~WavWriter() {
+    try {
+        close();
+    } catch (std::exception&) {
+        // Nobody is left to report it to
+    }
+}
+
+void WavWriter::write_header(uint64_t num_samples) {
+    // Sizes past 4 GB don't fit in a WAV file, so very long captures keep the largest size it can describe
+    uint32_t data_size = static_cast<uint32_t>(std::min<uint64_t>(num_samples * sizeof(int16_t), UINT32_MAX - HEADER_SIZE));
+    uint8_t header[HEADER_SIZE];
+
+    std::copy_n("RIFF", 4, header);
+    put_u32(header + 4, HEADER_SIZE - 8 + data_size);
+    std::copy_n("WAVE", 4, header + 8);
+
+    std::copy_n("fmt ", 4, header + 12);
+    put_u32(header + 16, 16);                               // Size of the format chunk
+    put_u16(header + 20, 1);                                // PCM
+    put_u16(header + 22, 1);                                // Mono
+    put_u32(header + 24, SAMPLE_RATE);
+    put_u32(header + 28, SAMPLE_RATE * sizeof(int16_t));    // Bytes per second
+    put_u16(header + 32, sizeof(int16_t));                  // Bytes per sample frame
+    put_u16(header + 34, 16);                               // Bits per sample
+
+    std::copy_n("data", 4, header + 36);
+    put_u32(header + 40, data_size);
+
+    if (std::fseek(file, 0, SEEK_SET) != 0 || std::fwrite(header, 1, HEADER_SIZE, file) != HEADER_SIZE) {
+        write_failed = true;
+    }
+}
+
+void WavWriter::write_samples(const int16_t* samples, size_t num_samples) {
+    size_t written = ring.write(samples, num_samples);
+
+    // Only reached if the disk is much slower than emulation. Losing samples would spoil the capture, so wait instead
+    while (written < num_samples) {
+        producer_waits++;
+        writer_wake.notify_one();
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        written += ring.write(samples + written, num_samples - written);
+    }
+}
+
+void WavWriter::drain(size_t min_samples) {
+    while (ring.size() >= min_samples && ring.size() > 0) {
+        size_t count = ring.read(write_block.data(), write_block.size());
+
+        // Samples are stored in host order, which is little endian on every platform this builds for
+        if (std::fwrite(write_block.data(), sizeof(int16_t), count, file) != count) {
+            write_failed = true;
+        }
+
+        samples_written += count;
+    }
+}
+
+void WavWriter::run_writer() {
+    std::unique_lock<std::mutex> guard(writer_lock);
+
+    while (!writer_wake.wait_for(guard, WRITER_INTERVAL, [this] { return stopping; })) {
+        drain(WRITE_BLOCK_SAMPLES);
+    }
+}
+
+void WavWriter::close() {
+    if (file == nullptr) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> guard(writer_lock);
+        stopping = true;
+    }
+
+    writer_wake.notify_one();
+    writer.join();
+
+    // The writer has stopped, so whatever it left behind can be written from here
+    drain(0);
+    write_header(samples_written);
+
+    if (std::fclose(file) != 0) {
+        write_failed = true;
+    }
+
+    file = nullptr;
+
+    if (write_failed) {
+        throw std::runtime_error("Failed to write " + path);
+    }
+}
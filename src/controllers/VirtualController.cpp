@@ -0,0 +1,36 @@
+#include "controllers/VirtualController.h"
+
+void VirtualController::set_buttons(uint8_t new_buttons) {
+    buttons = new_buttons;
+}
+
+bool VirtualController::read_input() {
+    if (is_strobing) {
+        return buttons & 1;
+    }
+
+    // After all 8 buttons have been read, an official controller returns 1
+    if (controller_state >= 8) {
+        return true;
+    }
+
+    return (buttons >> controller_state++) & 1;
+}
+
+void VirtualController::set_strobe(bool strobe_status) {
+    is_strobing = strobe_status;
+
+    if (is_strobing) {
+        controller_state = 0;
+    }
+}
+
+void VirtualController::save_state(StateWriter& state) const {
+    Controller::save_state(state);
+    state.write(controller_state);
+}
+
+void VirtualController::load_state(StateReader& state) {
+    Controller::load_state(state);
+    state.read(controller_state);
+}
@@ -0,0 +1,62 @@
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+#include "frontend/AudioStream.h"
+
+AudioStream::AudioStream(unsigned target_latency_ms) :
+    ring(2 * static_cast<size_t>(SAMPLE_RATE) * target_latency_ms / 1000),
+    target_fill(static_cast<size_t>(SAMPLE_RATE) * target_latency_ms / 1000) {
+    initialize(1, SAMPLE_RATE);
+}
+
+AudioStream::~AudioStream() {
+    // The audio thread reads the ring, so it has to be stopped before the ring goes away
+    stop();
+}
+
+void AudioStream::write_samples(const int16_t* samples, size_t num_samples) {
+    // A millisecond of audio is only 48 samples, so sleeping that long keeps the level close to the target without spinning.
+    // A stream that isn't playing is never drained, so it can't pace anything
+    while (paces_emulation.load(std::memory_order_relaxed) && ring.size() >= target_fill && getStatus() == sf::SoundSource::Playing) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    size_t written = ring.write(samples, num_samples);
+
+    if (written < num_samples) {
+        overflowed_samples += num_samples - written;
+    }
+}
+
+double AudioStream::requested_sample_rate() const {
+    // Below the target fill, produce slightly more samples per emulated second; above it, slightly fewer.
+    // The change is proportional to the distance from the target, so the fill level settles instead of oscillating
+    double fill = static_cast<double>(ring.size());
+    double error = (static_cast<double>(target_fill) - fill) / target_fill;
+    error = std::clamp(error, -1.0, 1.0);
+
+    return SAMPLE_RATE * (1.0 + MAX_RATE_ADJUSTMENT * error);
+}
+
+double AudioStream::latency_ms() const {
+    return 1000.0 * ring.size() / SAMPLE_RATE;
+}
+
+bool AudioStream::onGetData(Chunk& data) {
+    size_t num_read = ring.read(chunk.data(), chunk.size());
+
+    // Returning fewer samples would stop the stream, so fill the rest with silence
+    if (num_read < chunk.size()) {
+        underruns++;
+        std::fill(chunk.begin() + num_read, chunk.end(), 0);
+    }
+
+    data.samples = chunk.data();
+    data.sampleCount = chunk.size();
+    return true;
+}
+
+void AudioStream::onSeek(sf::Time) {
+    // A live stream can't seek
+}
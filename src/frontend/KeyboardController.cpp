@@ -0,0 +1,32 @@
+#include <SFML/Window.hpp>
+
+#include "frontend/KeyboardController.h"
+
+void KeyboardController::poll_keyboard() {
+    uint8_t new_buttons = 0;
+
+    new_buttons |= sf::Keyboard::isKeyPressed(sf::Keyboard::Key::A) << 0;
+    new_buttons |= sf::Keyboard::isKeyPressed(sf::Keyboard::Key::B) << 1;
+    new_buttons |= sf::Keyboard::isKeyPressed(sf::Keyboard::Key::O) << 2; // Select
+    new_buttons |= sf::Keyboard::isKeyPressed(sf::Keyboard::Key::P) << 3; // Start
+    new_buttons |= sf::Keyboard::isKeyPressed(sf::Keyboard::Key::Up) << 4;
+    new_buttons |= sf::Keyboard::isKeyPressed(sf::Keyboard::Key::Down) << 5;
+    new_buttons |= sf::Keyboard::isKeyPressed(sf::Keyboard::Key::Left) << 6;
+    new_buttons |= sf::Keyboard::isKeyPressed(sf::Keyboard::Key::Right) << 7;
+
+    set_buttons(new_buttons);
+}
+
+bool KeyboardController::read_input() {
+    // While strobing, the controller keeps reloading and reports the live state of A
+    if (is_strobing) {
+        return sf::Keyboard::isKeyPressed(sf::Keyboard::Key::A);
+    }
+
+    return VirtualController::read_input();
+}
+
+void KeyboardController::set_strobe(bool strobe_status) {
+    poll_keyboard();
+    VirtualController::set_strobe(strobe_status);
+}
@@ -1,4 +1,4 @@
-#include "RomPicker.h"
+#include "frontend/RomPicker.h"
 
 #include <SFML/Graphics.hpp>
 #include <SFML/Window.hpp>
@@ -0,0 +1,58 @@
+#include "frontend/UI.h"
+
+void PixelMap::draw(sf::RenderTarget& target, sf::RenderStates states) const
+{
+    // apply the entity's transform -- combine it with the one that was passed by the caller
+    states.transform *= getTransform(); // getTransform() is defined by sf::Transformable
+
+    // you may also override states.shader or states.blendMode if you want
+
+    // draw the vertex array
+    target.draw(vertices, states);
+}
+
+void PixelMap::load(const Screen& screen, const int scale_factor) {
+    vertices.setPrimitiveType(sf::Triangles);
+    vertices.resize(SCREEN_WIDTH * SCREEN_HEIGHT * 6);
+
+    for (int i = 0; i < SCREEN_HEIGHT; i++) {
+        for (int j = 0; j < SCREEN_WIDTH; j++) {
+            sf::Color pixel_color = sf::Color(Screen::COLORS[screen.pixels[i * SCREEN_WIDTH + j]]);
+
+            // 2 triangles per pixel, so we skip 6 vertices
+            sf::Vertex* triangles = &vertices[(i * SCREEN_WIDTH + j) * 6];
+
+            triangles[0].position = sf::Vector2f(j * scale_factor, i * scale_factor);
+            triangles[1].position = sf::Vector2f((j + 1) * scale_factor, i * scale_factor);
+            triangles[2].position = sf::Vector2f(j * scale_factor, (i + 1) * scale_factor);
+            triangles[3].position = sf::Vector2f((j + 1) * scale_factor, i * scale_factor);
+            triangles[4].position = sf::Vector2f(j * scale_factor, (i + 1) * scale_factor);
+            triangles[5].position = sf::Vector2f((j + 1) * scale_factor, (i + 1) * scale_factor);
+
+            triangles[0].color = pixel_color;
+            triangles[1].color = pixel_color;
+            triangles[2].color = pixel_color;
+            triangles[3].color = pixel_color;
+            triangles[4].color = pixel_color;
+            triangles[5].color = pixel_color;
+
+        }
+    }
+}
+
+UI::UI() {
+    window = new sf::RenderWindow(sf::VideoMode(WINDOW_WIDTH, WINDOW_HEIGHT), "NES Emulator");
+}
+
+UI::~UI() {
+    delete window;
+}
+
+void UI::present_frame(const Screen& screen) {
+    PixelMap pixels;
+    pixels.load(screen, SCALE_FACTOR);
+
+    window->clear();
+    window->draw(pixels);
+    window->display();
+}
\ No newline at end of file
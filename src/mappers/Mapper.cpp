@@ -1,9 +1,21 @@
 
 #include "mappers/Mapper.h"
 
-Mapper::Mapper(uint8_t prg_rom_banks, uint8_t prg_ram_banks, uint8_t chr_banks, uint16_t ram_bank_size) {
+Mapper::Mapper(uint16_t prg_rom_banks, uint8_t prg_ram_banks, uint16_t chr_banks, uint16_t ram_bank_size) {
     num_prg_rom_banks = prg_rom_banks;
     num_prg_ram_banks = prg_ram_banks;
     num_chr_banks = chr_banks;
     prg_ram_bank_size = ram_bank_size;
-}
\ No newline at end of file
+}
+
+void Mapper::save_state(StateWriter& state) const {
+    state.write_buffer(PRG_RAM.data(), PRG_RAM.size());
+}
+
+void Mapper::load_state(StateReader& state) {
+    state.read_buffer(PRG_RAM.mutable_data(), PRG_RAM.size());
+}
+
+void Mapper::attach_cartridge(Cartridge* new_cartridge) {
+    cartridge = new_cartridge;
+}
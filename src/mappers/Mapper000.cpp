@@ -57,6 +57,10 @@ bool Mapper000::ppu_mapper_write(uint16_t addr, uint32_t& mapped_addr, uint8_t d
     return false;    
 }
 
+Mapper* Mapper000::clone() const {
+    return new Mapper000(*this);
+}
+
 void Mapper000::reset() {
     
 }
@@ -66,5 +70,5 @@ bool Mapper000::mapped_to_prg_ram(uint16_t addr) {
 }
 
 std::vector<uint8_t> Mapper000::get_prg_ram() {
-    return PRG_RAM;
+    return std::vector<uint8_t>(PRG_RAM.data(), PRG_RAM.data() + PRG_RAM.size());
 }
\ No newline at end of file
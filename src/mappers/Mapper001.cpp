@@ -1,13 +1,14 @@
 
 #include <stdexcept>
 #include <iostream>
+#include "Cartridge.h"
 #include "mappers/Mapper001.h"
 
 bool Mapper001::cpu_mapper_read(uint16_t addr, uint32_t& mapped_addr, uint8_t& data) {
 
     if (mapped_to_prg_ram(addr)) {
         // 8 KB PRG-RAM bank, (optional)
-        data = PRG_RAM.at(addr - 0x6000);
+        data = PRG_RAM.at((addr - 0x6000) % PRG_RAM.size());
         return false; // Not reading from cartridge, so return true
     }
 
@@ -39,7 +40,7 @@ bool Mapper001::cpu_mapper_write(uint16_t addr, uint32_t& mapped_addr, uint8_t d
     }
 
     if (mapped_to_prg_ram(addr)) {
-        PRG_RAM.at(addr - 0x6000) = data;
+        PRG_RAM.set((addr - 0x6000) % PRG_RAM.size(), data);
         return true; // We write to cartridge, so return true
     } else if (addr >= 0x6000 && addr <= 0x7FFF) {
         return false;
@@ -48,6 +49,7 @@ bool Mapper001::cpu_mapper_write(uint16_t addr, uint32_t& mapped_addr, uint8_t d
     if (data & 0x80) {
         // Reset
         reset();
+        prg_banks_changed = true;
     } else {
         control_reg = (control_reg >> 1) | ((data & 0x1) << 4);
         control_reg_write_bit++;        
@@ -56,13 +58,19 @@ bool Mapper001::cpu_mapper_write(uint16_t addr, uint32_t& mapped_addr, uint8_t d
             if (addr >= 0x8000 && addr <= 0x9FFF) {
                 prg_rom_bank_mode = (control_reg & 0xC) >> 2;
                 chr_rom_bank_mode = control_reg >> 4;
+                set_mirroring(control_reg & 0x3);
+                prg_banks_changed = true;
+                chr_banks_changed = true;
             } else if (addr >= 0xA000 && addr <= 0xBFFF) {
                 switch_banks_chr(control_reg, 0);
+                chr_banks_changed = true;
             } else if (addr >= 0xC000 && addr <= 0xDFFF) {
                 switch_banks_chr(control_reg, 1);
+                chr_banks_changed = true;
             } else if (addr >= 0xE000 && addr <= 0xFFFF) {
                 switch_banks_prg(control_reg & 0xF);
                 prg_ram_enabled = (control_reg & 0x10) == 0;
+                prg_banks_changed = true;
             }
             
             control_reg_write_bit = 0;
@@ -110,6 +118,10 @@ bool Mapper001::ppu_mapper_write(uint16_t addr, uint32_t& mapped_addr, uint8_t d
     return false;
 }
 
+Mapper* Mapper001::clone() const {
+    return new Mapper001(*this);
+}
+
 void Mapper001::reset() {
     // A write with bit set will reset shift register and write Control with (Control OR $0C), 
     // locking PRG-ROM at $C000-$FFFF to the last bank.
@@ -122,7 +134,7 @@ void Mapper001::reset() {
 }
 
 bool Mapper001::mapped_to_prg_ram(uint16_t addr) {
-    return addr >= 0x6000 && addr <= 0x7FFF && prg_ram_enabled;
+    return addr >= 0x6000 && addr <= 0x7FFF && prg_ram_enabled && PRG_RAM.size() > 0;
 }
 
 void Mapper001::switch_banks_prg(uint8_t bank_num) {
@@ -146,22 +158,59 @@ void Mapper001::switch_banks_chr(uint8_t new_bank_num, uint8_t which_bank) {
     // which_bank == 0: Switch low
     // which_bank == 1: Switch high
 
-    if (which_bank == 0) {
-        if (chr_rom_bank_mode == 0) {
-            // 1 8 KiB bank
-            chr_bank_low = new_bank_num;
-        } else {
-            // 2 4 KiB banks
-            chr_bank_low = new_bank_num;
-            chr_bank_high = new_bank_num + 1;
+    if (chr_rom_bank_mode == 0) {
+        // 1 8 KiB bank, selected by the low register with its lowest bit ignored. Writes to the high register do nothing
+        if (which_bank == 0) {
+            chr_bank_low = new_bank_num & 0x1E;
+            chr_bank_high = chr_bank_low + 1;
         }
     } else {
-        if (chr_rom_bank_mode == 0) {
+        // 2 4 KiB banks
+        if (which_bank == 0) {
+            chr_bank_low = new_bank_num;
+        } else {
             chr_bank_high = new_bank_num;
         }
     }
 }
 
+void Mapper001::set_mirroring(uint8_t mirroring) {
+    // 0: one-screen, lower bank; 1: one-screen, upper bank; 2: vertical; 3: horizontal
+    const MIRRORING_TYPE MIRRORING_MODES[4] = {SINGLE_SCREEN_A, SINGLE_SCREEN_B, VERTICAL, HORIZONTAL};
+
+    cartridge->set_mirroring(MIRRORING_MODES[mirroring]);
+}
+
 vector<uint8_t> Mapper001::get_prg_ram() {
-    return PRG_RAM;
-}
\ No newline at end of file
+    return std::vector<uint8_t>(PRG_RAM.data(), PRG_RAM.data() + PRG_RAM.size());
+}
+
+void Mapper001::save_state(StateWriter& state) const {
+    Mapper::save_state(state);
+
+    state.write(prg_bank_low);
+    state.write(prg_bank_high);
+    state.write(prg_bank_32k);
+    state.write(chr_bank_low);
+    state.write(chr_bank_high);
+    state.write(control_reg_write_bit);
+    state.write(control_reg);
+    state.write(prg_rom_bank_mode);
+    state.write(chr_rom_bank_mode);
+    state.write(prg_ram_enabled);
+}
+
+void Mapper001::load_state(StateReader& state) {
+    Mapper::load_state(state);
+
+    state.read(prg_bank_low);
+    state.read(prg_bank_high);
+    state.read(prg_bank_32k);
+    state.read(chr_bank_low);
+    state.read(chr_bank_high);
+    state.read(control_reg_write_bit);
+    state.read(control_reg);
+    state.read(prg_rom_bank_mode);
+    state.read(chr_rom_bank_mode);
+    state.read(prg_ram_enabled);
+}
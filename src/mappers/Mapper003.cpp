@@ -20,7 +20,9 @@ bool Mapper003::cpu_mapper_read(uint16_t addr, uint32_t& mapped_addr, uint8_t& d
 
 bool Mapper003::cpu_mapper_write(uint16_t addr, uint32_t& mapped_addr, uint8_t data) {
     if (addr >= 0x8000 && addr <= 0xFFFF) {
-        this->cur_chr_bank = data & 0x3;
+        uint8_t new_chr_bank = data & 0x3;
+        chr_banks_changed |= new_chr_bank != cur_chr_bank;
+        this->cur_chr_bank = new_chr_bank;
         return true;
     }
 
@@ -43,6 +45,10 @@ bool Mapper003::ppu_mapper_write(uint16_t addr, uint32_t& mapped_addr, uint8_t d
     return false;
 }
 
+Mapper* Mapper003::clone() const {
+    return new Mapper003(*this);
+}
+
 void Mapper003::reset() {
 
 }
@@ -54,4 +60,14 @@ bool Mapper003::mapped_to_prg_ram(uint16_t addr) {
 
 std::vector<uint8_t> Mapper003::get_prg_ram() {
     return std::vector<uint8_t>();
-}
\ No newline at end of file
+}
+
+void Mapper003::save_state(StateWriter& state) const {
+    Mapper::save_state(state);
+    state.write(cur_chr_bank);
+}
+
+void Mapper003::load_state(StateReader& state) {
+    Mapper::load_state(state);
+    state.read(cur_chr_bank);
+}
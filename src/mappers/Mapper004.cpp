@@ -0,0 +1,237 @@
+#include <cstring>
+
+#include "Cartridge.h"
+#include "mappers/Mapper004.h"
+
+Mapper004::Mapper004(uint16_t prg_rom_banks, size_t prg_ram_size, uint16_t chr_rom_banks) : Mapper(prg_rom_banks, (prg_ram_size + 0x1FFF) / 0x2000, chr_rom_banks, 0x2000) {
+    PRG_RAM = CowBuffer(prg_ram_size);
+    watches_ppu_a12 = true;
+    update_banks();
+}
+
+bool Mapper004::cpu_mapper_read(uint16_t addr, uint32_t& mapped_addr, uint8_t& data) {
+
+    if (mapped_to_prg_ram(addr)) {
+        data = PRG_RAM.at((addr - 0x6000) % PRG_RAM.size());
+        return false;
+    }
+
+    if (addr >= 0x8000) {
+        mapped_addr = prg_bank_offsets[(addr - 0x8000) / PRG_BANK_SIZE] + (addr % PRG_BANK_SIZE);
+        return true;
+    }
+
+    return false;
+}
+
+bool Mapper004::cpu_mapper_write(uint16_t addr, uint32_t& /* mapped_addr */, uint8_t data) {
+
+    if (mapped_to_prg_ram(addr)) {
+        if (!prg_ram_write_protected) {
+            PRG_RAM.set((addr - 0x6000) % PRG_RAM.size(), data);
+        }
+        return true;
+    }
+
+    if (addr < 0x8000) {
+        return false;
+    }
+
+    // Each 8 KB range has two registers, picked by the lowest address bit
+    switch (addr & 0xE001) {
+        case 0x8000:
+            bank_select = data;
+            update_banks();
+            break;
+        case 0x8001:
+            bank_registers[bank_select & 0x7] = data;
+            update_banks();
+            break;
+        case 0xA000:
+            // Boards wired for four screen VRAM ignore this
+            if (cartridge != nullptr && cartridge->mirroring_type != FOUR_SCREEN) {
+                cartridge->set_mirroring((data & 0x1) ? HORIZONTAL : VERTICAL);
+            }
+            break;
+        case 0xA001:
+            prg_ram_enabled = (data & 0x80) != 0;
+            prg_ram_write_protected = (data & 0x40) != 0;
+            break;
+        case 0xC000:
+            irq_latch = data;
+            break;
+        case 0xC001:
+            // The counter is reloaded from the latch on the next clock
+            irq_counter = 0;
+            irq_reload = true;
+            break;
+        case 0xE000:
+            // Disabling also acknowledges a pending IRQ
+            irq_enabled = false;
+            irq_pending = false;
+            break;
+        case 0xE001:
+            irq_enabled = true;
+            break;
+    }
+
+    // We never edit PRG ROM
+    return false;
+}
+
+bool Mapper004::ppu_mapper_read(uint16_t addr, uint32_t& mapped_addr) {
+    if (addr <= 0x1FFF) {
+        mapped_addr = chr_bank_offsets[addr / CHR_BANK_SIZE] + (addr % CHR_BANK_SIZE);
+        return true;
+    }
+
+    return false;
+}
+
+bool Mapper004::ppu_mapper_write(uint16_t addr, uint32_t& mapped_addr, uint8_t /* data */) {
+    if (addr <= 0x1FFF) {
+        mapped_addr = chr_bank_offsets[addr / CHR_BANK_SIZE] + (addr % CHR_BANK_SIZE);
+        return true;
+    }
+
+    return false;
+}
+
+void Mapper004::notify_pattern_fetch(uint16_t addr, uint64_t dot) {
+    bool is_high = addr & 0x1000;
+
+    // Only a rise after A12 has been low for a while clocks the counter. A12 only counts as low once a fetch
+    // from 0x0000 - 0x0FFF is seen: a gap between two fetches from 0x1000 - 0x1FFF (such as the one between
+    // the last background prefetch and the next line) is just nametable fetches
+    if (is_high && !is_a12_high && dot - a12_low_dot > A12_LOW_FILTER_DOTS) {
+        clock_irq_counter();
+    }
+
+    if (!is_high && is_a12_high) {
+        a12_low_dot = dot;
+    }
+
+    is_a12_high = is_high;
+}
+
+void Mapper004::clock_irq_counter() {
+    if (irq_counter == 0 || irq_reload) {
+        irq_counter = irq_latch;
+        irq_reload = false;
+    } else {
+        irq_counter--;
+    }
+
+    if (irq_counter == 0 && irq_enabled) {
+        irq_pending = true;
+    }
+}
+
+void Mapper004::update_banks() {
+    uint32_t old_prg_bank_offsets[4];
+    uint32_t old_chr_bank_offsets[8];
+    std::memcpy(old_prg_bank_offsets, prg_bank_offsets, sizeof(prg_bank_offsets));
+    std::memcpy(old_chr_bank_offsets, chr_bank_offsets, sizeof(chr_bank_offsets));
+
+    // Bank numbers past the end of the ROM are wrapped by the cartridge
+    uint32_t second_last_prg_bank = (2 * num_prg_rom_banks - 2) * PRG_BANK_SIZE;
+    uint32_t last_prg_bank = (2 * num_prg_rom_banks - 1) * PRG_BANK_SIZE;
+    uint32_t r6 = (bank_registers[6] & 0x3F) * PRG_BANK_SIZE;
+    uint32_t r7 = (bank_registers[7] & 0x3F) * PRG_BANK_SIZE;
+
+    // Bit 6 of bank select swaps the windows at 0x8000 and 0xC000
+    if (bank_select & 0x40) {
+        prg_bank_offsets[0] = second_last_prg_bank;
+        prg_bank_offsets[2] = r6;
+    } else {
+        prg_bank_offsets[0] = r6;
+        prg_bank_offsets[2] = second_last_prg_bank;
+    }
+
+    prg_bank_offsets[1] = r7;
+    prg_bank_offsets[3] = last_prg_bank;
+
+    // R0 and R1 ignore their lowest bit, since they select 2 KB banks
+    uint32_t chr_banks[8] = {
+        static_cast<uint32_t>(bank_registers[0] & 0xFE),
+        static_cast<uint32_t>(bank_registers[0] | 0x01),
+        static_cast<uint32_t>(bank_registers[1] & 0xFE),
+        static_cast<uint32_t>(bank_registers[1] | 0x01),
+        bank_registers[2],
+        bank_registers[3],
+        bank_registers[4],
+        bank_registers[5]
+    };
+
+    // Bit 7 of bank select swaps the 2 KB banks into 0x1000 - 0x1FFF, and the 1 KB banks into 0x0000 - 0x0FFF
+    unsigned int inversion = (bank_select & 0x80) ? 4 : 0;
+
+    for (unsigned int window = 0; window < 8; window++) {
+        chr_bank_offsets[window ^ inversion] = chr_banks[window] * CHR_BANK_SIZE;
+    }
+
+    // Selecting a bank register, or rewriting one with the same bank, moves nothing
+    prg_banks_changed |= std::memcmp(old_prg_bank_offsets, prg_bank_offsets, sizeof(prg_bank_offsets)) != 0;
+    chr_banks_changed |= std::memcmp(old_chr_bank_offsets, chr_bank_offsets, sizeof(chr_bank_offsets)) != 0;
+}
+
+Mapper* Mapper004::clone() const {
+    return new Mapper004(*this);
+}
+
+void Mapper004::reset() {
+    irq_enabled = false;
+    irq_pending = false;
+    irq_reload = false;
+    irq_counter = 0;
+}
+
+bool Mapper004::mapped_to_prg_ram(uint16_t addr) {
+    return addr >= 0x6000 && addr <= 0x7FFF && prg_ram_enabled && PRG_RAM.size() > 0;
+}
+
+std::vector<uint8_t> Mapper004::get_prg_ram() {
+    return std::vector<uint8_t>(PRG_RAM.data(), PRG_RAM.data() + PRG_RAM.size());
+}
+
+void Mapper004::save_state(StateWriter& state) const {
+    Mapper::save_state(state);
+
+    state.write(bank_select);
+
+    for (uint8_t bank_register : bank_registers) {
+        state.write(bank_register);
+    }
+
+    state.write(prg_ram_enabled);
+    state.write(prg_ram_write_protected);
+    state.write(irq_latch);
+    state.write(irq_counter);
+    state.write(irq_reload);
+    state.write(irq_enabled);
+    state.write(irq_pending);
+    state.write(is_a12_high);
+    state.write(a12_low_dot);
+}
+
+void Mapper004::load_state(StateReader& state) {
+    Mapper::load_state(state);
+
+    state.read(bank_select);
+
+    for (uint8_t& bank_register : bank_registers) {
+        state.read(bank_register);
+    }
+
+    state.read(prg_ram_enabled);
+    state.read(prg_ram_write_protected);
+    state.read(irq_latch);
+    state.read(irq_counter);
+    state.read(irq_reload);
+    state.read(irq_enabled);
+    state.read(irq_pending);
+    state.read(is_a12_high);
+    state.read(a12_low_dot);
+
+    update_banks();
+}
@@ -0,0 +1,79 @@
+#include "mappers/Mapper031.h"
+
+bool Mapper031::cpu_mapper_read(uint16_t addr, uint32_t& mapped_addr, uint8_t& data) {
+
+    if (mapped_to_prg_ram(addr)) {
+        data = PRG_RAM.at((addr - 0x6000) % PRG_RAM.size());
+        return false;
+    }
+
+    if (addr >= 0x8000) {
+        // Bank numbers past the end of the ROM are wrapped by the cartridge
+        mapped_addr = prg_banks[(addr - 0x8000) / PRG_BANK_SIZE] * PRG_BANK_SIZE + (addr % PRG_BANK_SIZE);
+        return true;
+    }
+
+    return false;
+}
+
+bool Mapper031::cpu_mapper_write(uint16_t addr, uint32_t& /* mapped_addr */, uint8_t data) {
+
+    if (mapped_to_prg_ram(addr)) {
+        PRG_RAM.set((addr - 0x6000) % PRG_RAM.size(), data);
+        return true;
+    }
+
+    if (addr >= BANK_REGISTER_START && addr <= 0x5FFF) {
+        uint8_t& bank = prg_banks[addr - BANK_REGISTER_START];
+        prg_banks_changed |= bank != data;
+        bank = data;
+        return true;
+    }
+
+    return false;
+}
+
+bool Mapper031::ppu_mapper_read(uint16_t addr, uint32_t& mapped_addr) {
+    if (addr <= 0x1FFF) {
+        mapped_addr = addr;
+        return true;
+    }
+    return false;
+}
+
+bool Mapper031::ppu_mapper_write(uint16_t addr, uint32_t& mapped_addr, uint8_t /* data */) {
+    // CHR RAM, unless the header gave CHR ROM
+    if (addr <= 0x1FFF && num_chr_banks == 0) {
+        mapped_addr = addr;
+        return true;
+    }
+    return false;
+}
+
+Mapper* Mapper031::clone() const {
+    return new Mapper031(*this);
+}
+
+void Mapper031::reset() {
+
+}
+
+bool Mapper031::mapped_to_prg_ram(uint16_t addr) {
+    return addr >= 0x6000 && addr <= 0x7FFF && PRG_RAM.size() > 0;
+}
+
+std::vector<uint8_t> Mapper031::get_prg_ram() {
+    return std::vector<uint8_t>(PRG_RAM.data(), PRG_RAM.data() + PRG_RAM.size());
+}
+
+void Mapper031::save_state(StateWriter& state) const {
+    Mapper::save_state(state);
+
+    state.write(prg_banks);
+}
+
+void Mapper031::load_state(StateReader& state) {
+    Mapper::load_state(state);
+
+    state.read(prg_banks);
+}
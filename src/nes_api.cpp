@@ -0,0 +1,304 @@
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "nes_api.h"
+#include "Bus.h"
+#include "AudioOutput.h"
+#include "VecEnv.h"
+#include "controllers/VirtualController.h"
+
+// Collects the samples the APU produces during one frame.
+// The buffer is allocated once, so filling it never touches the heap
+struct SampleCapture : AudioOutput {
+    static const size_t CAPACITY = 48000;
+
+    std::vector<int16_t> samples = std::vector<int16_t>(CAPACITY);
+    size_t num_samples = 0;
+
+    void write_samples(const int16_t* new_samples, size_t count) override {
+        // Anything past one second per frame is dropped rather than reallocating
+        size_t num_to_copy = std::min(count, CAPACITY - num_samples);
+        std::memcpy(samples.data() + num_samples, new_samples, num_to_copy * sizeof(int16_t));
+        num_samples += num_to_copy;
+    }
+};
+
+struct nes_instance {
+    std::unique_ptr<Bus> bus;
+    std::unique_ptr<Cartridge> cartridge;
+
+    VirtualController port1;
+    VirtualController port2;
+
+    SampleCapture audio;
+
+    // Reused by nes_save_state so saving doesn't allocate after the first call
+    std::vector<uint8_t> state_buffer;
+
+    uint32_t frame_skip = 0;
+
+    std::string last_error;
+};
+
+static int fail(nes_instance* nes, const std::string& message) {
+    nes->last_error = message;
+    return -1;
+}
+
+static bool has_rom(nes_instance* nes) {
+    if (nes->bus == nullptr) {
+        nes->last_error = "No ROM loaded";
+        return false;
+    }
+
+    return true;
+}
+
+int nes_api_version(void) {
+    return NES_API_VERSION;
+}
+
+nes_instance* nes_create(void) {
+    try {
+        return new nes_instance();
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+void nes_destroy(nes_instance* nes) {
+    delete nes;
+}
+
+int nes_load_rom_from_memory(nes_instance* nes, const uint8_t* rom_data, size_t rom_size) {
+    try {
+        std::unique_ptr<Cartridge> cartridge = std::make_unique<Cartridge>(rom_data, rom_size);
+        std::unique_ptr<Bus> bus = std::make_unique<Bus>();
+
+        bus->io->connect_controller(&nes->port1, 1);
+        bus->io->connect_controller(&nes->port2, 2);
+        bus->apu->attach_audio_output(&nes->audio);
+        bus->ppu->set_frame_skip(nes->frame_skip);
+        bus->insert_cartridge(cartridge.get());
+        bus->reset();
+
+        // Replace the old machine only once the new one is ready
+        nes->bus = std::move(bus);
+        nes->cartridge = std::move(cartridge);
+        nes->audio.num_samples = 0;
+        nes->state_buffer.clear();
+    } catch (std::exception& e) {
+        return fail(nes, e.what());
+    }
+
+    return 0;
+}
+
+int nes_run_frame(nes_instance* nes) {
+    if (!has_rom(nes)) {
+        return -1;
+    }
+
+    nes->audio.num_samples = 0;
+
+    try {
+        nes->bus->run_frame();
+    } catch (std::exception& e) {
+        return fail(nes, e.what());
+    }
+
+    return 0;
+}
+
+int nes_set_frame_skip(nes_instance* nes, unsigned frame_skip) {
+    nes->frame_skip = frame_skip;
+
+    if (nes->bus != nullptr) {
+        nes->bus->ppu->set_frame_skip(frame_skip);
+    }
+
+    return 0;
+}
+
+int nes_set_input(nes_instance* nes, int port, uint8_t buttons) {
+    if (port == 1) {
+        nes->port1.set_buttons(buttons);
+    } else if (port == 2) {
+        nes->port2.set_buttons(buttons);
+    } else {
+        return fail(nes, "Controller port must be 1 or 2");
+    }
+
+    return 0;
+}
+
+size_t nes_state_size(nes_instance* nes) {
+    if (!has_rom(nes)) {
+        return 0;
+    }
+
+    try {
+        nes->state_buffer.clear();
+        nes->bus->save_state(nes->state_buffer);
+    } catch (std::exception& e) {
+        fail(nes, e.what());
+        return 0;
+    }
+
+    return nes->state_buffer.size();
+}
+
+int nes_save_state(nes_instance* nes, uint8_t* buffer, size_t buffer_size) {
+    if (!has_rom(nes)) {
+        return -1;
+    }
+
+    try {
+        nes->state_buffer.clear();
+        nes->bus->save_state(nes->state_buffer);
+    } catch (std::exception& e) {
+        return fail(nes, e.what());
+    }
+
+    if (buffer_size < nes->state_buffer.size()) {
+        return fail(nes, "Save state buffer is too small, need " + std::to_string(nes->state_buffer.size()) + " bytes");
+    }
+
+    std::memcpy(buffer, nes->state_buffer.data(), nes->state_buffer.size());
+
+    return 0;
+}
+
+int nes_load_state(nes_instance* nes, const uint8_t* buffer, size_t buffer_size) {
+    if (!has_rom(nes)) {
+        return -1;
+    }
+
+    try {
+        nes->bus->load_state(buffer, buffer_size);
+    } catch (std::exception& e) {
+        return fail(nes, e.what());
+    }
+
+    return 0;
+}
+
+const uint8_t* nes_get_framebuffer(nes_instance* nes) {
+    if (!has_rom(nes)) {
+        return nullptr;
+    }
+
+    return nes->bus->ppu->screen.pixels.data();
+}
+
+const uint32_t* nes_get_palette(void) {
+    return Screen::COLORS;
+}
+
+uint8_t* nes_get_ram(nes_instance* nes) {
+    if (!has_rom(nes)) {
+        return nullptr;
+    }
+
+    return nes->bus->cpu_RAM.data();
+}
+
+uint64_t nes_frame_hash(nes_instance* nes) {
+    if (!has_rom(nes)) {
+        return 0;
+    }
+
+    return nes->bus->hash_frame();
+}
+
+uint64_t nes_state_hash(nes_instance* nes) {
+    if (!has_rom(nes)) {
+        return 0;
+    }
+
+    return nes->bus->hash_state();
+}
+
+const int16_t* nes_get_audio_samples(nes_instance* nes, size_t* num_samples) {
+    if (num_samples != nullptr) {
+        *num_samples = nes->audio.num_samples;
+    }
+
+    return nes->audio.samples.data();
+}
+
+const char* nes_get_last_error(nes_instance* nes) {
+    return nes->last_error.c_str();
+}
+
+struct nes_vec_env {
+    std::unique_ptr<VecEnv> env;
+
+    std::string last_error;
+};
+
+nes_vec_env* nes_vec_create(const uint8_t* rom_data, size_t rom_size, size_t num_envs, unsigned num_threads,
+                            uint64_t boot_frames, uint64_t max_episode_frames) {
+    try {
+        nes_vec_env* vec = new nes_vec_env();
+        vec->env = std::make_unique<VecEnv>(rom_data, rom_size, num_envs, num_threads, boot_frames, max_episode_frames);
+        return vec;
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+void nes_vec_destroy(nes_vec_env* vec) {
+    delete vec;
+}
+
+int nes_vec_step(nes_vec_env* vec, const uint8_t* inputs) {
+    try {
+        vec->env->step(inputs);
+    } catch (std::exception& e) {
+        vec->last_error = e.what();
+        return -1;
+    }
+
+    return 0;
+}
+
+int nes_vec_reset(nes_vec_env* vec, size_t index) {
+    try {
+        vec->env->reset(index);
+    } catch (std::exception& e) {
+        vec->last_error = e.what();
+        return -1;
+    }
+
+    return 0;
+}
+
+const uint8_t* nes_vec_observations(nes_vec_env* vec) {
+    return vec->env->observations.data();
+}
+
+const uint8_t* nes_vec_ram(nes_vec_env* vec) {
+    return vec->env->ram.data();
+}
+
+const uint8_t* nes_vec_dones(nes_vec_env* vec) {
+    return vec->env->dones.data();
+}
+
+void nes_vec_stats(nes_vec_env* vec, double* mean_step_latency_us, double* frames_per_second) {
+    if (mean_step_latency_us != nullptr) {
+        *mean_step_latency_us = vec->env->mean_step_latency_us();
+    }
+
+    if (frames_per_second != nullptr) {
+        *frames_per_second = vec->env->frames_per_second();
+    }
+}
+
+const char* nes_vec_get_last_error(nes_vec_env* vec) {
+    return vec->last_error.c_str();
+}
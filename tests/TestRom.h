@@ -0,0 +1,56 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+// Builds iNES images in memory, so tests run without any ROM files.
+// The program is placed at program_address in the last 16 KB of PRG ROM, which every supported mapper
+// has fixed at 0xC000 - 0xFFFF at power on, and the rest of PRG ROM is filled with NOPs
+struct TestRom {
+    uint8_t mapper = 0;
+    uint8_t num_prg_rom_banks = 1;
+    uint8_t num_chr_rom_banks = 1;
+    bool vertical_mirroring = false;
+
+    uint16_t program_address = 0xC000;
+    std::vector<uint8_t> program;
+
+    uint16_t nmi_address = 0xC000;
+    uint16_t reset_address = 0xC000;
+    uint16_t irq_address = 0xC000;
+
+    std::vector<uint8_t> build() const {
+        const size_t HEADER_SIZE = 16;
+        size_t prg_size = num_prg_rom_banks * 0x4000;
+        size_t chr_size = num_chr_rom_banks * 0x2000;
+
+        std::vector<uint8_t> image(HEADER_SIZE + prg_size + chr_size, 0);
+
+        image[0] = 'N';
+        image[1] = 'E';
+        image[2] = 'S';
+        image[3] = 0x1A;
+        image[4] = num_prg_rom_banks;
+        image[5] = num_chr_rom_banks;
+        image[6] = ((mapper & 0x0F) << 4) | (vertical_mirroring ? 1 : 0);
+        image[7] = mapper & 0xF0;
+
+        uint8_t* prg = image.data() + HEADER_SIZE;
+        std::fill(prg, prg + prg_size, 0xEA);
+
+        // Offset of 0xC000 in PRG ROM
+        size_t last_bank = prg_size - 0x4000;
+
+        std::copy(program.begin(), program.end(), prg + last_bank + (program_address - 0xC000));
+
+        uint16_t vectors[3] = {nmi_address, reset_address, irq_address};
+
+        for (int i = 0; i < 3; i++) {
+            prg[prg_size - 6 + 2 * i] = vectors[i] & 0xFF;
+            prg[prg_size - 5 + 2 * i] = vectors[i] >> 8;
+        }
+
+        return image;
+    }
+};
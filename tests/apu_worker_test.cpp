@@ -0,0 +1,126 @@
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#include "APUWorker.h"
+#include "AudioOutput.h"
+#include "Bus.h"
+#include "TestRom.h"
+
+// Runs a program which plays every channel, including a looping DMC sample, and hammers the APU with register writes,
+// $4015 reads and frame counter IRQs. Synthesizing on an APUWorker must give exactly the samples the APU makes on the
+// emulation thread, and the program, which sees $4015 and the IRQs, must run exactly the same way
+
+const int NUM_FRAMES = 120;
+
+struct RecordingAudioOutput : AudioOutput {
+    std::vector<int16_t> samples;
+
+    void write_samples(const int16_t* new_samples, size_t count) override {
+        samples.insert(samples.end(), new_samples, new_samples + count);
+    }
+};
+
+std::vector<uint8_t> make_rom() {
+    TestRom rom;
+    rom.irq_address = 0xC058;
+    rom.program = {
+        0x78,                   // C000: SEI
+        0xA9, 0xBF,             //       LDA #$BF    Pulse 1: 50% duty, constant volume 15
+        0x8D, 0x00, 0x40,       //       STA $4000
+        0xA9, 0xFD,             //       LDA #$FD
+        0x8D, 0x02, 0x40,       //       STA $4002
+        0xA9, 0x00,             //       LDA #0
+        0x8D, 0x03, 0x40,       //       STA $4003
+        0xA9, 0xFF,             //       LDA #$FF    Triangle: linear counter halted
+        0x8D, 0x08, 0x40,       //       STA $4008
+        0xA9, 0x40,             //       LDA #$40
+        0x8D, 0x0A, 0x40,       //       STA $400A
+        0xA9, 0x08,             //       LDA #$08
+        0x8D, 0x0B, 0x40,       //       STA $400B
+        0xA9, 0x3F,             //       LDA #$3F    Noise: constant volume 15, length counter halted
+        0x8D, 0x0C, 0x40,       //       STA $400C
+        0xA9, 0x05,             //       LDA #$05
+        0x8D, 0x0E, 0x40,       //       STA $400E
+        0xA9, 0x00,             //       LDA #0
+        0x8D, 0x0F, 0x40,       //       STA $400F
+        0xA9, 0x4F,             //       LDA #$4F    DMC: looping, fastest rate
+        0x8D, 0x10, 0x40,       //       STA $4010
+        0xA9, 0x00,             //       LDA #0      Sample at $C000, this program
+        0x8D, 0x12, 0x40,       //       STA $4012
+        0xA9, 0x10,             //       LDA #$10    257 bytes long
+        0x8D, 0x13, 0x40,       //       STA $4013
+        0xA9, 0x1F,             //       LDA #$1F    Enable everything
+        0x8D, 0x15, 0x40,       //       STA $4015
+        0xA9, 0x00,             //       LDA #0      4-step sequence, with IRQs
+        0x8D, 0x17, 0x40,       //       STA $4017
+        0x58,                   //       CLI
+        0xAD, 0x15, 0x40,       // C048: LDA $4015   Main loop: count, and sweep the pulse and DMC levels with the count
+        0xE6, 0x10,             //       INC $10
+        0xA5, 0x10,             //       LDA $10
+        0x8D, 0x02, 0x40,       //       STA $4002
+        0x8D, 0x11, 0x40,       //       STA $4011
+        0x4C, 0x48, 0xC0,       //       JMP $C048
+        0xAD, 0x15, 0x40,       // C058: LDA $4015   IRQ: acknowledge and count
+        0xE6, 0x11,             //       INC $11
+        0x40,                   //       RTI
+    };
+
+    return rom.build();
+}
+
+struct Run {
+    std::vector<int16_t> samples;
+    std::vector<uint8_t> ram;
+    uint64_t frames_synthesized = 0;
+};
+
+Run run(const std::vector<uint8_t>& image, bool use_worker) {
+    Cartridge cartridge(image.data(), image.size());
+    RecordingAudioOutput audio;
+    std::unique_ptr<APUWorker> worker;
+    Bus nes;
+
+    if (use_worker) {
+        worker = std::make_unique<APUWorker>(&audio);
+        nes.apu->attach_worker(worker.get());
+    } else {
+        nes.apu->attach_audio_output(&audio);
+    }
+
+    nes.insert_cartridge(&cartridge);
+    nes.reset();
+
+    for (int i = 0; i < NUM_FRAMES; i++) {
+        nes.run_frame();
+    }
+
+    Run result;
+
+    if (use_worker) {
+        nes.apu->catch_up();
+        nes.apu->attach_worker(nullptr);
+        result.frames_synthesized = worker->frames_synthesized;
+    }
+
+    result.samples = audio.samples;
+    result.ram = nes.cpu_RAM;
+    return result;
+}
+
+int main() {
+    std::vector<uint8_t> image = make_rom();
+
+    Run inline_run = run(image, false);
+    Run worker_run = run(image, true);
+
+    std::cout << "samples: " << inline_run.samples.size() << " on this thread, " << worker_run.samples.size() << " on the worker" << std::endl;
+    std::cout << "frames synthesized by the worker: " << worker_run.frames_synthesized << std::endl;
+    std::cout << "IRQs: " << static_cast<int>(inline_run.ram[0x11]) << std::endl;
+
+    bool ok = inline_run.samples.size() > NUM_FRAMES * 790 && inline_run.samples == worker_run.samples;
+    ok = ok && inline_run.ram == worker_run.ram && inline_run.ram[0x11] > 0;
+    ok = ok && worker_run.frames_synthesized >= NUM_FRAMES - 1;
+
+    return ok ? 0 : 1;
+}
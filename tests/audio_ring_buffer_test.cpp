@@ -0,0 +1,74 @@
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "AudioRingBuffer.h"
+
+// A producer thread writes a counting sequence in uneven pieces while a consumer thread reads it back in
+// pieces of another size. Every sample must arrive exactly once and in order, across many wraps of the ring
+
+const uint32_t NUM_SAMPLES = 1000000;
+
+int main() {
+    AudioRingBuffer ring(1000);
+
+    if (ring.capacity() != 1024) {
+        std::cerr << "capacity " << ring.capacity() << ", expected 1024" << std::endl;
+        return 1;
+    }
+
+    std::thread producer([&ring]() {
+        std::vector<int16_t> piece(301);
+        uint32_t next = 0;
+
+        while (next < NUM_SAMPLES) {
+            size_t count = std::min<size_t>(piece.size() - next % 7, NUM_SAMPLES - next);
+
+            for (size_t i = 0; i < count; i++) {
+                piece[i] = static_cast<int16_t>(next + i);
+            }
+
+            size_t written = 0;
+
+            while (written < count) {
+                size_t count_written = ring.write(piece.data() + written, count - written);
+                written += count_written;
+
+                // Let the consumer run when the ring is full, in case both share a core
+                if (count_written == 0) {
+                    std::this_thread::yield();
+                }
+            }
+
+            next += count;
+        }
+    });
+
+    std::vector<int16_t> piece(177);
+    uint32_t expected = 0;
+    uint64_t mismatches = 0;
+
+    while (expected < NUM_SAMPLES) {
+        size_t count = ring.read(piece.data(), piece.size());
+
+        for (size_t i = 0; i < count; i++) {
+            if (piece[i] != static_cast<int16_t>(expected + i)) {
+                mismatches++;
+            }
+        }
+
+        expected += count;
+
+        if (count == 0) {
+            std::this_thread::yield();
+        }
+    }
+
+    producer.join();
+
+    std::cout << "samples: " << expected << ", mismatches: " << mismatches << ", left over: " << ring.size() << std::endl;
+
+    return mismatches == 0 && ring.size() == 0 ? 0 : 1;
+}
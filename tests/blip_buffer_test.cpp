@@ -0,0 +1,90 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include "APU.h"
+#include "AudioOutput.h"
+#include "BlipBuffer.h"
+
+// Feeds the same pseudo-random amplitude changes through each of add_delta's paths (AVX2 when this CPU has it, SSE2,
+// and whichever add_delta dispatches to) and through add_delta_scalar. The samples read back must agree, allowing
+// for fused multiply-adds rounding differently
+
+const int NUM_BLOCKS = 240;
+
+typedef void (BlipBuffer::*AddDelta)(uint32_t, int);
+
+std::vector<int16_t> resample(AddDelta add_delta) {
+    BlipBuffer buffer(APU::CPU_CLOCK_RATE, AudioOutput::SAMPLE_RATE, 2 * AudioOutput::SAMPLE_RATE / 60);
+    std::vector<int16_t> block(2 * AudioOutput::SAMPLE_RATE / 60);
+    std::vector<int16_t> samples;
+
+    uint32_t random = 12345;
+    int amplitude = 0;
+
+    for (int i = 0; i < NUM_BLOCKS; i++) {
+        for (uint32_t time = random % 64; time < APU::BLOCK_CYCLES; time += 1 + random % 200) {
+            random = random * 1103515245 + 12345;
+
+            int next_amplitude = (random >> 8) % 20000;
+
+            (buffer.*add_delta)(time, next_amplitude - amplitude);
+
+            amplitude = next_amplitude;
+        }
+
+        buffer.end_block(APU::BLOCK_CYCLES);
+        size_t count = buffer.read_samples(block.data(), block.size());
+        samples.insert(samples.end(), block.begin(), block.begin() + count);
+    }
+
+    return samples;
+}
+
+// Returns the largest difference from the scalar samples, or -1 if the sample counts differ
+int compare(const char* name, AddDelta add_delta, const std::vector<int16_t>& scalar_samples) {
+    std::vector<int16_t> samples = resample(add_delta);
+
+    if (samples.size() != scalar_samples.size()) {
+        std::cerr << name << ": sample counts " << samples.size() << " and " << scalar_samples.size() << std::endl;
+        return -1;
+    }
+
+    int max_difference = 0;
+
+    for (size_t i = 0; i < samples.size(); i++) {
+        max_difference = std::max(max_difference, std::abs(samples[i] - scalar_samples[i]));
+    }
+
+    std::cout << name << ": " << samples.size() << " samples, largest difference " << max_difference << std::endl;
+    return max_difference;
+}
+
+int main() {
+    std::vector<int16_t> scalar_samples = resample(&BlipBuffer::add_delta_scalar);
+
+    if (scalar_samples.size() < NUM_BLOCKS * 190) {
+        std::cerr << "only " << scalar_samples.size() << " samples" << std::endl;
+        return 1;
+    }
+
+    std::vector<int> differences;
+    differences.push_back(compare("SSE2", &BlipBuffer::add_delta_sse2, scalar_samples));
+    differences.push_back(compare(BlipBuffer::vector_extension(), &BlipBuffer::add_delta, scalar_samples));
+
+    if (BlipBuffer::has_avx2()) {
+        differences.push_back(compare("AVX2", &BlipBuffer::add_delta_avx2, scalar_samples));
+    } else {
+        std::cout << "AVX2: not supported by this CPU, skipped" << std::endl;
+    }
+
+    bool ok = true;
+
+    for (int difference : differences) {
+        ok = ok && difference >= 0 && difference <= 1;
+    }
+
+    return ok ? 0 : 1;
+}
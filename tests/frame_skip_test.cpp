@@ -0,0 +1,152 @@
+#include <iostream>
+#include <vector>
+
+#include "Bus.h"
+#include "TestRom.h"
+#include "VideoOutput.h"
+
+// Runs a program which times sprite 0 hits and counts NMIs, once drawing every frame and once skipping two frames in
+// every three. Game logic must not notice: the machine states have to hash the same after every frame. The frames which are drawn must
+// match pixel for pixel, and the skipped ones must never reach the video output
+
+const int NUM_FRAMES = 60;
+const uint32_t FRAME_SKIP = 2;
+
+struct RecordingVideoOutput : VideoOutput {
+    std::vector<std::vector<uint8_t>> frames;
+    std::vector<uint16_t> frame_numbers;
+    const PPU* ppu = nullptr;
+
+    void present_frame(const Screen& screen) override {
+        frames.push_back(screen.pixels);
+        frame_numbers.push_back(ppu->frames_elapsed);
+    }
+};
+
+std::vector<uint8_t> make_rom() {
+    TestRom rom;
+    rom.num_chr_rom_banks = 0;
+    rom.nmi_address = 0xC08C;
+    rom.program = {
+        0xA9, 0x00,             //       LDA #0
+        0x8D, 0x00, 0x20,       //       STA $2000   Rendering and NMIs off while setting up
+        0x8D, 0x01, 0x20,       //       STA $2001
+        0xA9, 0x00,             //       LDA #$00    CHR RAM tile 1 (0x0010 - 0x001F): every pixel opaque
+        0x8D, 0x06, 0x20,       //       STA $2006
+        0xA9, 0x10,             //       LDA #$10
+        0x8D, 0x06, 0x20,       //       STA $2006
+        0xA9, 0xFF,             //       LDA #$FF
+        0xA2, 0x10,             //       LDX #16
+        0x8D, 0x07, 0x20,       // C016: STA $2007
+        0xCA,                   //       DEX
+        0xD0, 0xFA,             //       BNE $C016
+        0xA9, 0x20,             //       LDA #$20    Nametable 0 and its attributes, all tile 1
+        0x8D, 0x06, 0x20,       //       STA $2006
+        0xA9, 0x00,             //       LDA #$00
+        0x8D, 0x06, 0x20,       //       STA $2006
+        0xA9, 0x01,             //       LDA #1
+        0xA0, 0x04,             //       LDY #4
+        0xA2, 0x00,             // C02A: LDX #0
+        0x8D, 0x07, 0x20,       // C02C: STA $2007
+        0xCA,                   //       DEX
+        0xD0, 0xFA,             //       BNE $C02C
+        0x88,                   //       DEY
+        0xD0, 0xF5,             //       BNE $C02A
+        0xA9, 0x3F,             //       LDA #$3F    Palettes
+        0x8D, 0x06, 0x20,       //       STA $2006
+        0xA9, 0x00,             //       LDA #$00
+        0x8D, 0x06, 0x20,       //       STA $2006
+        0xA2, 0x20,             //       LDX #32
+        0x8E, 0x07, 0x20,       // C041: STX $2007
+        0xCA,                   //       DEX
+        0xD0, 0xFA,             //       BNE $C041
+        0xA9, 0x00,             //       LDA #0      Sprite 0 at (100, 100), tile 1
+        0x8D, 0x03, 0x20,       //       STA $2003
+        0xA9, 0x64,             //       LDA #100
+        0x8D, 0x04, 0x20,       //       STA $2004
+        0xA9, 0x01,             //       LDA #1
+        0x8D, 0x04, 0x20,       //       STA $2004
+        0xA9, 0x00,             //       LDA #0
+        0x8D, 0x04, 0x20,       //       STA $2004
+        0xA9, 0x64,             //       LDA #100
+        0x8D, 0x04, 0x20,       //       STA $2004
+        0xA9, 0x00,             //       LDA #0
+        0x8D, 0x05, 0x20,       //       STA $2005
+        0x8D, 0x05, 0x20,       //       STA $2005
+        0xA9, 0x80,             //       LDA #$80    NMIs on
+        0x8D, 0x00, 0x20,       //       STA $2000
+        0xA9, 0x1E,             //       LDA #$1E    Background and sprites on, left columns too
+        0x8D, 0x01, 0x20,       //       STA $2001
+        0x2C, 0x02, 0x20,       // C072: BIT $2002   Main loop: wait for the hit flag to clear
+        0x70, 0xFB,             //       BVS $C072
+        0xA2, 0x00,             //       LDX #0
+        0xE8,                   // C079: INX         Count until sprite 0 hits
+        0x2C, 0x02, 0x20,       //       BIT $2002
+        0x50, 0xFA,             //       BVC $C079
+        0x86, 0x10,             //       STX $10
+        0x8A,                   //       TXA         Sum of the counts
+        0x18,                   //       CLC
+        0x65, 0x11,             //       ADC $11
+        0x85, 0x11,             //       STA $11
+        0xE6, 0x12,             //       INC $12     Hits seen
+        0x4C, 0x72, 0xC0,       //       JMP $C072
+        0xE6, 0x13,             // C08C: INC $13     NMI: count
+        0x40,                   //       RTI
+    };
+
+    return rom.build();
+}
+
+int main() {
+    std::vector<uint8_t> image = make_rom();
+
+    Cartridge cartridge_drawn(image.data(), image.size());
+    Cartridge cartridge_skipped(image.data(), image.size());
+    RecordingVideoOutput video_drawn;
+    RecordingVideoOutput video_skipped;
+    Bus drawn;
+    Bus skipped;
+
+    video_drawn.ppu = drawn.ppu;
+    video_skipped.ppu = skipped.ppu;
+
+    drawn.ppu->attach_video_output(&video_drawn);
+    drawn.insert_cartridge(&cartridge_drawn);
+    drawn.reset();
+
+    skipped.ppu->attach_video_output(&video_skipped);
+    skipped.ppu->set_frame_skip(FRAME_SKIP);
+    skipped.insert_cartridge(&cartridge_skipped);
+    skipped.reset();
+
+    bool ok = true;
+
+    for (int frame = 0; frame < NUM_FRAMES; frame++) {
+        drawn.run_frame();
+        skipped.run_frame();
+
+        if (drawn.hash_state() != skipped.hash_state()) {
+            std::cerr << "machines differ after frame " << frame << std::endl;
+            ok = false;
+            break;
+        }
+    }
+
+    for (size_t i = 0; i < video_skipped.frames.size(); i++) {
+        uint16_t frame = video_skipped.frame_numbers[i];
+
+        if (frame % (FRAME_SKIP + 1) != 0 || video_skipped.frames[i] != video_drawn.frames.at(frame)) {
+            std::cerr << "frame " << frame << " differs, or shouldn't have been presented" << std::endl;
+            ok = false;
+        }
+    }
+
+    std::cout << "sprite 0 hits: " << static_cast<int>(drawn.cpu_RAM[0x12]) << ", NMIs: " << static_cast<int>(drawn.cpu_RAM[0x13])
+              << ", last hit after " << static_cast<int>(drawn.cpu_RAM[0x10]) << " (mod 256) polls" << std::endl;
+    std::cout << "frames presented: " << video_drawn.frames.size() << " drawing every frame, " << video_skipped.frames.size() << " skipping" << std::endl;
+
+    ok = ok && drawn.cpu_RAM[0x12] >= NUM_FRAMES - 2 && drawn.cpu_RAM[0x13] >= NUM_FRAMES - 2;
+    ok = ok && video_drawn.frames.size() == NUM_FRAMES && video_skipped.frames.size() == NUM_FRAMES / (FRAME_SKIP + 1);
+
+    return ok ? 0 : 1;
+}
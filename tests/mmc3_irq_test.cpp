@@ -0,0 +1,151 @@
+#include <iostream>
+#include <vector>
+
+#include "Bus.h"
+#include "TestRom.h"
+
+// The MMC3 scanline counter must clock once per rendered line, whichever pattern table the background and
+// sprites use. Each layout runs a program which reloads the counter with 20 every frame, so the IRQ line
+// should rise every 21 scanlines: 11 times in the 241 lines the PPU fetches on
+
+const uint8_t IRQ_LATCH = 20;
+
+// Sets up the counter and turns on rendering with the given PPUCTRL, then acknowledges and re-enables every IRQ
+std::vector<uint8_t> make_program(uint8_t ppuctrl) {
+    return {
+        0x78,                   // C000: SEI
+        0xD8,                   //       CLD
+        0xA2, 0xFF,             //       LDX #$FF
+        0x9A,                   //       TXS
+        0xA9, 0x40,             //       LDA #$40    No APU frame IRQ
+        0x8D, 0x17, 0x40,       //       STA $4017
+        0x2C, 0x02, 0x20,       // C00A: BIT $2002
+        0x10, 0xFB,             //       BPL $C00A
+        0x2C, 0x02, 0x20,       // C00F: BIT $2002
+        0x10, 0xFB,             //       BPL $C00F
+        0xA9, IRQ_LATCH,        //       LDA #IRQ_LATCH
+        0x8D, 0x00, 0xC0,       //       STA $C000   IRQ latch
+        0x8D, 0x01, 0xC0,       //       STA $C001   Reload
+        0x8D, 0x01, 0xE0,       //       STA $E001   IRQ on
+        0xA9, ppuctrl,          //       LDA #ppuctrl
+        0x8D, 0x00, 0x20,       //       STA $2000
+        0xA9, 0x1E,             //       LDA #$1E
+        0x8D, 0x01, 0x20,       //       STA $2001
+        0x58,                   //       CLI
+        0x4C, 0x2A, 0xC0,       // C02A: JMP $C02A
+        0x8D, 0x01, 0xC0,       // C02D: STA $C001   NMI: reload the counter
+        0x40,                   //       RTI
+        0x8D, 0x00, 0xE0,       // C031: STA $E000   IRQ: acknowledge
+        0x8D, 0x01, 0xE0,       //       STA $E001
+        0x40,                   //       RTI
+    };
+}
+
+// Returns the number of failures
+int check_layout(const char* name, uint8_t ppuctrl) {
+    TestRom rom;
+    rom.mapper = 4;
+    rom.num_prg_rom_banks = 2;
+    rom.program = make_program(ppuctrl);
+    rom.nmi_address = 0xC02D;
+    rom.irq_address = 0xC031;
+
+    std::vector<uint8_t> image = rom.build();
+
+    Cartridge cartridge(image.data(), image.size());
+    Bus nes;
+    nes.insert_cartridge(&cartridge);
+    nes.reset();
+
+    // Let the program set everything up first
+    for (int i = 0; i < 5; i++) {
+        nes.run_frame();
+    }
+
+    const int NUM_FRAMES = 10;
+
+    int failures = 0;
+    Mapper* mapper = cartridge.mapper;
+
+    for (int frame = 0; frame < NUM_FRAMES; frame++) {
+        uint16_t cur_frame = nes.ppu->frames_elapsed;
+        std::vector<int> irq_scanlines;
+        bool was_pending = mapper->irq_pending;
+
+        while (nes.ppu->frames_elapsed == cur_frame) {
+            nes.tick();
+
+            if (mapper->irq_pending && !was_pending) {
+                irq_scanlines.push_back(nes.ppu->scanline);
+            }
+
+            was_pending = mapper->irq_pending;
+        }
+
+        bool evenly_spaced = true;
+
+        for (size_t i = 1; i < irq_scanlines.size(); i++) {
+            evenly_spaced &= irq_scanlines[i] - irq_scanlines[i - 1] == IRQ_LATCH + 1;
+        }
+
+        if (irq_scanlines.size() != 11 || !evenly_spaced) {
+            std::cerr << name << ": frame " << frame << " raised IRQs on scanlines";
+
+            for (int scanline : irq_scanlines) {
+                std::cerr << " " << scanline;
+            }
+
+            std::cerr << std::endl;
+            failures++;
+        }
+    }
+
+    std::cout << name << ": " << (failures == 0 ? "ok" : "FAILED") << std::endl;
+
+    return failures;
+}
+
+// The IRQ line is shared. Acknowledging the MMC3 must release only its own hold on it and leave a pending APU
+// frame counter IRQ alone, and reading $4015 must acknowledge only the frame counter
+int check_shared_line() {
+    TestRom rom;
+    rom.mapper = 4;
+    rom.num_prg_rom_banks = 2;
+    rom.program = make_program(0x88);
+
+    std::vector<uint8_t> image = rom.build();
+
+    Cartridge cartridge(image.data(), image.size());
+    Bus nes;
+    nes.insert_cartridge(&cartridge);
+    nes.reset();
+
+    nes.cpu->assert_IRQ(IRQ_APU_FRAME);
+    cartridge.mapper->irq_pending = true;
+    nes.cpu->assert_IRQ(IRQ_MAPPER);
+
+    nes.write_cpu(0xE000, 0);
+
+    bool ok = !cartridge.mapper->irq_pending && nes.cpu->irq_sources == IRQ_APU_FRAME;
+
+    cartridge.mapper->irq_pending = true;
+    nes.cpu->assert_IRQ(IRQ_MAPPER);
+    nes.read_cpu(0x4015);
+
+    ok = ok && nes.cpu->irq_sources == IRQ_MAPPER;
+    std::cout << "acknowledging the MMC3 and the APU with both IRQs pending: " << (ok ? "ok" : "FAILED") << std::endl;
+
+    return ok ? 0 : 1;
+}
+
+int main() {
+    int failures = 0;
+
+    failures += check_shared_line();
+
+    // NMI on, plus the pattern tables for the background (bit 4) and sprites (bit 3)
+    failures += check_layout("background at $0000, sprites at $1000", 0x88);
+    failures += check_layout("background at $1000, sprites at $0000", 0x90);
+
+    return failures == 0 ? 0 : 1;
+}
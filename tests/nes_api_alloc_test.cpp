@@ -0,0 +1,127 @@
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <vector>
+
+#include "nes_api.h"
+#include "TestRom.h"
+
+// nes_run_frame must not allocate: hosts run many instances on many threads, and the allocator would serialize them
+
+static std::atomic<uint64_t> num_allocations{0};
+
+void* operator new(size_t size) {
+    num_allocations++;
+
+    void* ptr = std::malloc(size == 0 ? 1 : size);
+
+    if (ptr == nullptr) {
+        throw std::bad_alloc();
+    }
+
+    return ptr;
+}
+
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+    std::free(ptr);
+}
+
+// Turns on rendering, NMI and all four tone channels, then OAM DMAs and counts frames in the NMI handler
+const std::vector<uint8_t> PROGRAM = {
+    0x78,                   // C000: SEI
+    0xD8,                   //       CLD
+    0xA2, 0xFF,             //       LDX #$FF
+    0x9A,                   //       TXS
+    0x2C, 0x02, 0x20,       // C005: BIT $2002   Wait for two vblanks while the PPU warms up
+    0x10, 0xFB,             //       BPL $C005
+    0x2C, 0x02, 0x20,       // C00A: BIT $2002
+    0x10, 0xFB,             //       BPL $C00A
+    0xA9, 0x0F,             //       LDA #$0F    Enable pulse 1, pulse 2, triangle and noise
+    0x8D, 0x15, 0x40,       //       STA $4015
+    0xA9, 0xBF,             //       LDA #$BF    Pulse 1: 50% duty, held, constant volume 15
+    0x8D, 0x00, 0x40,       //       STA $4000
+    0xA9, 0xFD,             //       LDA #$FD
+    0x8D, 0x02, 0x40,       //       STA $4002
+    0xA9, 0x00,             //       LDA #$00
+    0x8D, 0x03, 0x40,       //       STA $4003
+    0xA9, 0x81,             //       LDA #$81    Triangle: held
+    0x8D, 0x08, 0x40,       //       STA $4008
+    0xA9, 0x40,             //       LDA #$40
+    0x8D, 0x0A, 0x40,       //       STA $400A
+    0xA9, 0x00,             //       LDA #$00
+    0x8D, 0x0B, 0x40,       //       STA $400B
+    0xA9, 0x3F,             //       LDA #$3F    Noise: held, constant volume 15
+    0x8D, 0x0C, 0x40,       //       STA $400C
+    0xA9, 0x04,             //       LDA #$04
+    0x8D, 0x0E, 0x40,       //       STA $400E
+    0x8D, 0x0F, 0x40,       //       STA $400F
+    0xA9, 0x80,             //       LDA #$80    NMI on
+    0x8D, 0x00, 0x20,       //       STA $2000
+    0xA9, 0x1E,             //       LDA #$1E    Background and sprites on
+    0x8D, 0x01, 0x20,       //       STA $2001
+    0x4C, 0x49, 0xC0,       // C049: JMP $C049
+    0xE6, 0x00,             // C04C: INC $00     NMI handler
+    0xA9, 0x02,             //       LDA #$02
+    0x8D, 0x14, 0x40,       //       STA $4014
+    0x40,                   // C053: RTI
+};
+
+int main() {
+    TestRom rom;
+    rom.program = PROGRAM;
+    rom.nmi_address = 0xC04C;
+    rom.irq_address = 0xC053;
+
+    std::vector<uint8_t> image = rom.build();
+
+    nes_instance* nes = nes_create();
+
+    if (nes_load_rom_from_memory(nes, image.data(), image.size()) != 0) {
+        std::cerr << "Failed to load ROM: " << nes_get_last_error(nes) << std::endl;
+        return 1;
+    }
+
+    // Let the program set everything up first
+    for (int i = 0; i < 10; i++) {
+        nes_run_frame(nes);
+    }
+
+    const int NUM_FRAMES = 120;
+
+    uint64_t allocations_before = num_allocations;
+    size_t total_samples = 0;
+
+    for (int i = 0; i < NUM_FRAMES; i++) {
+        nes_set_input(nes, 1, i & 0xFF);
+
+        if (nes_run_frame(nes) != 0) {
+            std::cerr << "nes_run_frame failed: " << nes_get_last_error(nes) << std::endl;
+            return 1;
+        }
+
+        size_t num_samples;
+        nes_get_audio_samples(nes, &num_samples);
+        total_samples += num_samples;
+    }
+
+    uint64_t allocations = num_allocations - allocations_before;
+    uint8_t frames_counted = nes_get_ram(nes)[0];
+
+    nes_destroy(nes);
+
+    std::cout << "allocations in " << NUM_FRAMES << " frames: " << allocations << std::endl;
+    std::cout << "audio samples: " << total_samples << ", NMIs counted: " << static_cast<int>(frames_counted) << std::endl;
+
+    // Make sure the frames actually ran the PPU, NMI handler and APU
+    if (total_samples == 0 || frames_counted == 0) {
+        std::cerr << "The test program did not run" << std::endl;
+        return 1;
+    }
+
+    return allocations == 0 ? 0 : 1;
+}
@@ -0,0 +1,92 @@
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include "AudioOutput.h"
+#include "NsfPlayer.h"
+
+// Plays a bank switched NSF file built in memory. INIT switches a bank and starts a tone on the first pulse channel,
+// and PLAY counts its calls in CPU RAM and PRG RAM. One second should bring about 60 PLAY calls and 48000 samples,
+// with the PPU never running
+
+struct CountingAudioOutput : AudioOutput {
+    size_t num_samples = 0;
+    int peak = 0;
+
+    void write_samples(const int16_t* samples, size_t count) override {
+        num_samples += count;
+
+        for (size_t i = 0; i < count; i++) {
+            peak = std::max(peak, std::abs(static_cast<int>(samples[i])));
+        }
+    }
+};
+
+std::vector<uint8_t> make_nsf() {
+    const size_t HEADER_SIZE = 0x80;
+    const size_t BANK_SIZE = 0x1000;
+
+    std::vector<uint8_t> nsf(HEADER_SIZE + 3 * BANK_SIZE, 0);
+
+    const uint8_t header[] = {'N', 'E', 'S', 'M', 0x1A, 1, 3, 1, 0x00, 0x80, 0x00, 0x80, 0x20, 0x80};
+    std::copy(header, header + sizeof(header), nsf.begin());
+
+    // 60.1 Hz
+    nsf[0x6E] = 16639 & 0xFF;
+    nsf[0x6F] = 16639 >> 8;
+
+    // 0x9000 starts out as bank 2, which makes the file bank switched
+    nsf[0x71] = 2;
+
+    const uint8_t program[] = {
+        0x85, 0x00,             // 8000: STA $00     INIT: keep the song number
+        0xA9, 0x01,             //       LDA #1
+        0x8D, 0xF9, 0x5F,       //       STA $5FF9   Bank 1 at 0x9000
+        0xAD, 0x00, 0x90,       //       LDA $9000
+        0x85, 0x01,             //       STA $01
+        0xA9, 0xBF,             //       LDA #$BF    Pulse 1: 50% duty, constant volume 15
+        0x8D, 0x00, 0x40,       //       STA $4000
+        0xA9, 0xFD,             //       LDA #$FD
+        0x8D, 0x02, 0x40,       //       STA $4002
+        0xA9, 0x00,             //       LDA #0
+        0x8D, 0x03, 0x40,       //       STA $4003
+        0x60,                   //       RTS
+        0xEA, 0xEA, 0xEA, 0xEA, //       (padding up to 0x8020)
+        0xE6, 0x02,             // 8020: INC $02     PLAY: count the calls
+        0xEE, 0x00, 0x60,       //       INC $6000
+        0x60,                   //       RTS
+    };
+    std::copy(program, program + sizeof(program), nsf.begin() + HEADER_SIZE);
+
+    nsf[HEADER_SIZE + BANK_SIZE] = 0x5A;
+    nsf[HEADER_SIZE + 2 * BANK_SIZE] = 0xA5;
+
+    return nsf;
+}
+
+int main() {
+    std::vector<uint8_t> file = make_nsf();
+
+    NsfPlayer player(file.data(), file.size());
+    CountingAudioOutput audio;
+
+    player.nes.apu->attach_audio_output(&audio);
+    player.start_song(1);
+    player.run_seconds(1.0);
+
+    const std::vector<uint8_t>& ram = player.nes.cpu_RAM;
+    uint8_t prg_ram_count = player.cartridge->mapper->PRG_RAM.data()[0];
+
+    std::cout << "song " << static_cast<int>(ram[0]) << ", bank byte " << std::hex << static_cast<int>(ram[1]) << std::dec << std::endl;
+    std::cout << "PLAY calls: " << player.num_play_calls << " (RAM " << static_cast<int>(ram[2]) << ", PRG RAM " << static_cast<int>(prg_ram_count) << ")" << std::endl;
+    std::cout << "samples: " << audio.num_samples << ", peak " << audio.peak << ", frames rendered: " << player.nes.ppu->frames_elapsed << std::endl;
+
+    bool ok = ram[0] == 1 && ram[1] == 0x5A;
+    ok = ok && player.num_play_calls >= 60 && player.num_play_calls <= 61 && player.num_skipped_play_calls == 0;
+    ok = ok && ram[2] == player.num_play_calls && prg_ram_count == player.num_play_calls;
+    ok = ok && audio.num_samples > 47000 && audio.num_samples < 49000 && audio.peak > 1000;
+    ok = ok && player.nes.ppu->frames_elapsed == 0;
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,190 @@
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Bus.h"
+#include "Helpers.h"
+#include "TestRom.h"
+
+// Checks the XXH64 implementation against the reference test vectors, then the machine hashes: two runs of the same
+// program must hash the same at every frame even when their memory starts out different, a loaded state must hash
+// like the one it was saved from, and changing any of the parts the hash covers must change it
+
+const int NUM_FRAMES = 30;
+
+// CNROM, so there's a mapper register. Switches CHR bank and scribbles on the nametables every frame
+std::vector<uint8_t> make_rom() {
+    TestRom rom;
+    rom.mapper = 3;
+    rom.num_chr_rom_banks = 4;
+    rom.nmi_address = 0xC020;
+    rom.program = {
+        0xA9, 0x80,             // C000: LDA #$80    NMI on
+        0x8D, 0x00, 0x20,       //       STA $2000
+        0x4C, 0x05, 0xC0,       // C005: JMP $C005
+        0xEA, 0xEA, 0xEA, 0xEA, 0xEA, 0xEA, 0xEA, 0xEA,
+        0xEA, 0xEA, 0xEA, 0xEA, 0xEA, 0xEA, 0xEA, 0xEA,
+        0xEA, 0xEA, 0xEA, 0xEA, 0xEA, 0xEA, 0xEA, 0xEA,
+        0xE6, 0x10,             // C020: INC $10     NMI: count frames
+        0xA5, 0x10,             //       LDA $10
+        0x29, 0x03,             //       AND #3
+        0x8D, 0x00, 0x80,       //       STA $8000   CHR bank
+        0xA9, 0x20,             //       LDA #$20
+        0x8D, 0x06, 0x20,       //       STA $2006
+        0xA5, 0x10,             //       LDA $10
+        0x8D, 0x06, 0x20,       //       STA $2006
+        0x8D, 0x07, 0x20,       //       STA $2007   Nametable byte $20xx = frame count
+        0x40,                   //       RTI
+    };
+
+    return rom.build();
+}
+
+bool check_vectors() {
+    const std::string abc = "abc";
+    const std::string sentence = "Nobody inspects the spammish repetition";
+
+    bool ok = hash_bytes(reinterpret_cast<const uint8_t*>(abc.data()), 0) == 0xEF46DB3751D8E999;
+    ok = ok && hash_bytes(reinterpret_cast<const uint8_t*>(abc.data()), abc.size()) == 0x44BC2CF5AD770999;
+    ok = ok && hash_bytes(reinterpret_cast<const uint8_t*>(sentence.data()), sentence.size()) == 0xFBCEA83C8A378BF1;
+
+    // Odd piece sizes, so stripes get split every which way
+    std::vector<uint8_t> data(1000);
+
+    for (size_t i = 0; i < data.size(); i++) {
+        data[i] = i * 7;
+    }
+
+    StreamingHash pieces(42);
+
+    for (size_t position = 0, piece = 1; position < data.size(); piece = piece * 3 % 37 + 1) {
+        size_t length = std::min(piece, data.size() - position);
+        pieces.update(data.data() + position, length);
+        position += length;
+    }
+
+    return ok && pieces.digest() == hash_bytes(data.data(), data.size(), 42);
+}
+
+// Leaves freed blocks full of garbage behind, where the next machine's components are likely to be allocated
+void dirty_heap() {
+    std::vector<void*> blocks;
+
+    for (size_t size = 16; size < 80000; size = size * 5 / 4 + 1) {
+        void* block = std::malloc(size);
+        std::memset(block, 0xA5, size);
+        blocks.push_back(block);
+    }
+
+    for (void* block : blocks) {
+        std::free(block);
+    }
+}
+
+std::vector<uint64_t> run(const std::vector<uint8_t>& image) {
+    Cartridge cartridge(image.data(), image.size());
+    Bus nes;
+    std::vector<uint64_t> hashes;
+
+    nes.insert_cartridge(&cartridge);
+    nes.reset();
+
+    for (int i = 0; i < NUM_FRAMES; i++) {
+        nes.run_frame();
+        hashes.push_back(nes.hash_state());
+        hashes.push_back(nes.hash_frame());
+    }
+
+    return hashes;
+}
+
+// Changes a byte, checks the hash notices, and puts it back
+bool changes_hash(Bus& nes, uint8_t& byte, const char* name) {
+    uint64_t before = nes.hash_state();
+
+    byte ^= 1;
+    bool changed = nes.hash_state() != before;
+    byte ^= 1;
+
+    if (!changed || nes.hash_state() != before) {
+        std::cerr << "changing " << name << " doesn't change the state hash" << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+int main() {
+    bool ok = check_vectors();
+
+    if (!ok) {
+        std::cerr << "XXH64 doesn't match the reference vectors" << std::endl;
+    }
+
+    std::vector<uint8_t> image = make_rom();
+    std::vector<uint64_t> first_run = run(image);
+    dirty_heap();
+    std::vector<uint64_t> second_run = run(image);
+
+    if (first_run != second_run) {
+        std::cerr << "identical runs hash differently" << std::endl;
+        ok = false;
+    }
+
+    Cartridge cartridge(image.data(), image.size());
+    Cartridge loaded_cartridge(image.data(), image.size());
+    Bus nes;
+    Bus loaded;
+
+    nes.insert_cartridge(&cartridge);
+    nes.reset();
+    loaded.insert_cartridge(&loaded_cartridge);
+    loaded.reset();
+
+    for (int i = 0; i < NUM_FRAMES; i++) {
+        nes.run_frame();
+    }
+
+    std::vector<uint8_t> state;
+    nes.save_state(state);
+    loaded.load_state(state.data(), state.size());
+
+    nes.run_frame();
+    loaded.run_frame();
+
+    if (loaded.hash_state() != nes.hash_state() || loaded.hash_frame() != nes.hash_frame()) {
+        std::cerr << "a loaded state hashes differently" << std::endl;
+        ok = false;
+    }
+
+    ok = changes_hash(nes, nes.cpu_RAM[0x200], "CPU RAM") && ok;
+    ok = changes_hash(nes, nes.cpu->A, "the A register") && ok;
+    ok = changes_hash(nes, nes.ppu->VRAM.mutable_data()[0x123], "VRAM") && ok;
+    ok = changes_hash(nes, nes.ppu->primary_OAM[17], "OAM") && ok;
+    ok = changes_hash(nes, nes.ppu->PALETTE_RAM[5], "palette RAM") && ok;
+
+    uint64_t before_bank_switch = nes.hash_state();
+    nes.write_cpu(0x8000, (nes.cpu_RAM[0x10] + 1) & 0x03);
+
+    if (nes.hash_state() == before_bank_switch) {
+        std::cerr << "switching CHR banks doesn't change the state hash" << std::endl;
+        ok = false;
+    }
+
+    // The picture is hashed separately, so drawing differently mustn't change the state hash
+    uint64_t before_drawing = nes.hash_state();
+    nes.ppu->screen.pixels[1000] ^= 1;
+
+    if (nes.hash_state() != before_drawing) {
+        std::cerr << "the framebuffer changes the state hash" << std::endl;
+        ok = false;
+    }
+
+    std::cout << "frames hashed: " << NUM_FRAMES << ", final state hash: " << std::hex << first_run[2 * NUM_FRAMES - 2] << std::endl;
+
+    return ok ? 0 : 1;
+}